@@ -0,0 +1,58 @@
+# Runs the instrumented solver over the training corpora and hands its profile
+# to shamir_verify_pgo. Invoked by the shamir_pgo_train target with SOLVER,
+# GEN_DIR, USE_DIR, WORK_DIR and SOURCE_DIR set.
+#
+# The mix follows the traffic: mostly small k over Q (the fixed-width tier and
+# the integrality screens), then larger k through the exact engines, the GF(p)
+# path, bad-share decoding and a binary-format round trip.
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(GLOB stale ${GEN_DIR}/*.gcda)
+if(stale)
+  file(REMOVE ${stale})
+endif()
+
+function(train)
+  execute_process(COMMAND ${SOLVER} ${ARGN} WORKING_DIRECTORY ${WORK_DIR}
+                  OUTPUT_FILE ${WORK_DIR}/last.out ERROR_FILE ${WORK_DIR}/last.err RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "PGO training run failed (${rc}): ${ARGN}")
+  endif()
+endfunction()
+
+function(corpus file spec)
+  execute_process(COMMAND ${SOLVER} --gen ${spec} OUTPUT_FILE ${WORK_DIR}/${file} RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "PGO corpus generation failed (${rc}): ${spec}")
+  endif()
+endfunction()
+
+corpus(small.json count=3000,n=10,k=5,bits=64,bases=2:16,bad=2)
+corpus(small_wide.json count=1000,n=12,k=8,bits=160,bad=2)
+corpus(medium.json count=10,n=24,k=20,bits=256,bad=1)
+corpus(prime.json count=100,n=30,k=16,bits=128,bad=3,prime=115792089237316195423570985008687907853269984665640564039457584007908834671663)
+corpus(decode.json count=100,n=40,k=20,bits=128,bad=5)
+
+train(${SOURCE_DIR}/test.json)
+train(small.json)
+train(--jobs 2 small_wide.json)
+train(--search revolving small.json)
+train(medium.json)
+train(--engine crt medium.json)
+train(prime.json)
+train(--decode decode.json)
+train(--prune decode.json)
+train(--bench --gen count=200,n=10,k=6,bits=96,bad=1)
+
+execute_process(COMMAND ${SOLVER} --to-binary small.json WORKING_DIRECTORY ${WORK_DIR}
+                OUTPUT_FILE ${WORK_DIR}/small.bin RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "PGO training run failed (${rc}): --to-binary")
+endif()
+train(small.bin)
+
+if(NOT EXISTS ${GEN_DIR}/code.cpp.gcda)
+  message(FATAL_ERROR "PGO training left no profile in ${GEN_DIR}")
+endif()
+configure_file(${GEN_DIR}/code.cpp.gcda ${USE_DIR}/code.cpp.gcda COPYONLY)
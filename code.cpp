@@ -1,286 +1,931 @@
 // shamir_verify.cpp
-// Compile: g++ -std=c++17 -O2 shamir_verify.cpp -o shamir_verify
+// Compile: g++ -std=c++17 -O2 -pthread shamir_verify.cpp -o shamir_verify
+// or: cmake -S . -B build && cmake --build build, which also builds the
+// -march=native and profile-guided variants (see CMakeLists.txt).
 // Requires: Boost.Multiprecision header (usually available with g++)
-// Run: ./shamir_verify < testcases.json
-
-#include <bits/stdc++.h>
-#include <boost/multiprecision/cpp_int.hpp>
-using namespace std;
-using boost::multiprecision::cpp_int;
-
-// ---------- Fraction with cpp_int ----------
-struct Frac {
-    cpp_int num;
-    cpp_int den; // always > 0
-    Frac(cpp_int n = 0, cpp_int d = 1) {
-        if (d == 0) throw runtime_error("zero denominator");
-        if (d < 0) { n = -n; d = -d; }
-        cpp_int g = gcd_abs(n < 0 ? -n : n, d);
-        num = n / g; den = d / g;
-    }
-    static cpp_int gcd_abs(cpp_int a, cpp_int b) {
-        if (a < 0) a = -a;
-        if (b < 0) b = -b;
-        while (b != 0) {
-            cpp_int r = a % b;
-            a = b;
-            b = r;
-        }
-        return a;
-    }
-    Frac operator+(const Frac &o) const { return Frac(num * o.den + o.num * den, den * o.den); }
-    Frac operator-(const Frac &o) const { return Frac(num * o.den - o.num * den, den * o.den); }
-    Frac operator*(const Frac &o) const { return Frac(num * o.num, den * o.den); }
-    Frac operator/(const Frac &o) const {
-        if (o.num == 0) throw runtime_error("division by zero fraction");
-        return Frac(num * o.den, den * o.num);
-    }
-    bool isInteger() const { return den == 1; }
+// The solver itself is header-only (shamir_core.hpp, shamir_parse.hpp); this
+// file is the command-line front end around ShamirSolver.
+// Run: ./shamir_verify [options] [testcases.json]
+// Reads stdin when no file is given; a file is memory-mapped.
+//   --engine lagrange|gauss|bareiss|crt  exact interpolation engine (default lagrange); naming one
+//                                 also bypasses the fixed-width tier small objects otherwise use
+//   --search lex|revolving        subset order; the first valid subset wins (default lex)
+//   --threads N                   workers for the lex subset search
+//   --jobs N                      objects solved concurrently, output kept in order
+//   --listen unix:PATH|tcp:[HOST:]PORT  serve requests on a socket with --jobs workers, answering "<seq> <result>"
+//   --gen SPEC                    write a synthetic corpus, e.g. count=100,n=10,k=4,bits=128,bases=2:16,bad=1
+//   --to-binary                   convert JSON input (or a --gen corpus) to the binary share format
+//   --bench                       time parse/decode/interpolate/search/output per object, print JSON
+//   --time-limit MS               per-object search time limit; prints "TIMEOUT tried=<t>/<C(n,k)> elapsed_ms=<ms>"
+//   --max-combos N                per-object limit on subsets tried, reported the same way
+//   --stats                       per-object and total stage timings and counters as JSON lines on stderr
+//   --consensus T                 accept a candidate only if at least T shares lie on it
+//   --prune                       solve first the shares a sampled consistent (k+1)-window agrees on
+//   --decode                      correct up to (n-k)/2 bad shares, print "<constant> bad=<x,...>"
+//   --out-base N                  print the constant in base N (2..36; default 10)
+//   --weight-cache N              Lagrange weight sets kept in the LRU (default 16384; 0 disables)
+//   --weight-cache-file PATH      load the weight cache from PATH and save it back on exit
+//   --result-cache N              results of repeated share sets kept in an LRU (default 0, off)
+//   --result-cache-file PATH      load/save the result cache; enables it with 65536 entries unless N is given
+// A "prime" field under "keys" reconstructs that object in GF(p) instead of over Q.
+// Input may also be a binary share file (see shamir_parse.hpp); it is detected
+// by its magic and solved record by record with the same output.
+
+#include "shamir_parse.hpp"
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <csignal>
+using namespace shamir;
+
+// Counts heap allocations for --stats. Only the binary replaces operator new;
+// the headers leave it alone for embedders.
+__attribute__((noinline)) void *operator new(size_t size) {
+    if (g_count_allocs) ++StatCounters::local().allocs;
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Returns false with out_constant_str set to a TIMEOUT status line when a budget
+// ran out, and false with it empty on any other failure.
+bool solve_one_json_string(string_view obj_str, string &out_constant_str, const SolveOptions &opt) {
+    thread_local ShareParser parser;
+    thread_local ShareSet set;
+    thread_local ShamirSolver solver;
+    if (!parser.parse(obj_str, set)) return false;
+    solver.options() = opt;
+    const SolveResult &r = solver.solve(set);
+    out_constant_str = format_status(r, opt);
+    return r.ok();
+}
+
+// Malformed objects (bad digits, unparsable numbers) print as ERROR like any other failure.
+bool solve_or_error(string_view obj_str, string &out_constant_str, const SolveOptions &opt) {
+    try {
+        return solve_one_json_string(obj_str, out_constant_str, opt);
+    } catch (const exception &) {
+        return false;
+    }
+}
+
+// Solves one object with this thread's counters isolated, so stats holds
+// exactly this object's share and the thread totals stay cumulative.
+bool solve_counted(string_view obj_str, string &out_constant_str, const SolveOptions &opt, StatCounters &stats) {
+    StatCounters &local = StatCounters::local();
+    StatCounters saved = local;
+    local = StatCounters{};
+    bool ok = solve_or_error(obj_str, out_constant_str, opt);
+    stats = local;
+    local = saved;
+    local.merge(stats);
+    return ok;
+}
+
+// --stats output: one JSON line per object on stderr, in input order, then a
+// total that also carries the time spent splitting the input into objects.
+class StatsReport {
+public:
+    void object(bool ok, const StatCounters &s) {
+        print("object", objects_++, ok, s);
+        total_.merge(s);
+        solved_ += ok;
+    }
+    void finish(uint64_t split_ns) {
+        cerr << "{\"stats\": \"total\", \"objects\": " << objects_ << ", \"solved\": " << solved_
+             << ", \"split_ns\": " << split_ns << ", ";
+        fields(total_);
+        cerr << "}\n";
+    }
+
+private:
+    static void fields(const StatCounters &s) {
+        cerr << "\"parse_ns\": " << s.parse_ns << ", \"decode_ns\": " << s.decode_ns << ", \"search_ns\": " << s.search_ns
+             << ", \"interp_ns\": " << s.interp_ns << ", \"interp_calls\": " << s.interp_calls
+             << ", \"combos_tried\": " << s.combos_tried << ", \"combos_total\": " << s.combos_total
+             << ", \"peak_bits\": " << s.peak_bits << ", \"allocs\": " << s.allocs
+             << ", \"result_hits\": " << s.result_hits;
+    }
+    static void print(const char *kind, size_t index, bool ok, const StatCounters &s) {
+        cerr << "{\"stats\": \"" << kind << "\", \"index\": " << index << ", \"ok\": " << (ok ? "true" : "false") << ", ";
+        fields(s);
+        cerr << "}\n";
+    }
+
+    size_t objects_ = 0, solved_ = 0;
+    StatCounters total_;
 };
 
-// ---------- Utility: trim spaces ----------
-static inline void trim(string &s) {
-    size_t a = 0; while (a < s.size() && isspace((unsigned char)s[a])) ++a;
-    size_t b = s.size(); while (b > a && isspace((unsigned char)s[b-1])) --b;
-    s = s.substr(a, b - a);
+// ---------- Concurrent batch of objects ----------
+// Objects are solved on a fixed pool of threads but printed strictly in input
+// order. Only a window of objects past the last printed one is admitted, which
+// bounds the reorder buffer; inside the window the most expensive-looking
+// unstarted object is picked first, so a slow object starts early instead of
+// holding up the tail of the batch.
+class BatchRunner {
+public:
+    BatchRunner(const SolveOptions &opt, int jobs, size_t window, StatsReport *stats = nullptr)
+        : opt_(opt), window_(window), stats_(stats) {
+        for (int i = 0; i < jobs; ++i) pool_.emplace_back([this] { work(); });
+    }
+    ~BatchRunner() { finish(); }
+
+    // Without copy the text must stay valid until finish().
+    void submit(string_view obj, bool copy = false) {
+        unique_lock<mutex> lock(mu_);
+        space_.wait(lock, [&] { return pending_.size() < window_; });
+        pending_.emplace_back();
+        Job &job = pending_.back();
+        if (copy) {
+            job.owned.assign(obj);
+            obj = job.owned;
+        }
+        job.text = obj;
+        job.cost = estimate_cost(obj);
+        ready_.notify_one();
+    }
+
+    void finish() {
+        {
+            unique_lock<mutex> lock(mu_);
+            if (closed_) return;
+            closed_ = true;
+        }
+        ready_.notify_all();
+        for (auto &t : pool_) t.join();
+    }
+
+    bool any_printed() const { return any_printed_; }
+
+private:
+    struct Job {
+        string owned;
+        string_view text;
+        double cost = 0;
+        bool started = false, done = false, ok = false;
+        string out;
+        StatCounters stats;
+    };
+
+    // O(k^2) work per subset on values of about bytes/n, times log C(n, k)
+    // as a rough stand-in for how far the subset search may have to go.
+    static double estimate_cost(string_view s) {
+        double cost = (double)s.size();
+        if (is_binary_record(s))
+            return record_cost(cost, (double)load_le(s.data() + 4, 4), (double)load_le(s.data() + 8, 4));
+        try {
+            ParsedObject keys;
+            if (!parse_keys(s, keys) || !keys.has_n || !keys.has_k) return cost;
+            return record_cost(cost, (double)keys.n, (double)keys.k);
+        } catch (const exception &) {
+            return cost;
+        }
+    }
+    static double record_cost(double cost, double n, double k) {
+        if (n <= 0 || k <= 0 || k > n) return cost;
+        double log_combos = (lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1)) / log(2.0);
+        return cost * k * k / n * (1 + log_combos);
+    }
+
+    void work() {
+        unique_lock<mutex> lock(mu_);
+        while (true) {
+            Job *job = nullptr;
+            for (auto &j : pending_)
+                if (!j.started && (!job || j.cost > job->cost)) job = &j;
+            if (!job) {
+                if (closed_) return;
+                ready_.wait(lock);
+                continue;
+            }
+            job->started = true;
+            lock.unlock();
+            string out;
+            StatCounters stats;
+            bool ok = stats_ ? solve_counted(job->text, out, opt_, stats) : solve_or_error(job->text, out, opt_);
+            lock.lock();
+            job->stats = stats;
+            job->ok = ok;
+            job->out = move(out);
+            job->done = true;
+            bool flushed = false;
+            while (!pending_.empty() && pending_.front().done) {
+                const Job &front = pending_.front();
+                if (stats_) stats_->object(front.ok, front.stats);
+                if (front.ok) {
+                    cout << front.out << "\n";
+                    any_printed_ = true;
+                } else {
+                    cout << (front.out.empty() ? "ERROR" : front.out) << "\n";
+                }
+                pending_.pop_front();
+                flushed = true;
+            }
+            if (flushed) space_.notify_all();
+        }
+    }
+
+    const SolveOptions &opt_;
+    size_t window_;
+    StatsReport *stats_;
+    mutex mu_;
+    condition_variable ready_, space_;
+    deque<Job> pending_; // deque: Job pointers stay valid while others are pushed or popped
+    vector<thread> pool_;
+    bool closed_ = false;
+    bool any_printed_ = false;
+};
+
+// ---------- Benchmark and corpus generator ----------
+// --gen SPEC writes a synthetic corpus; --bench times each stage over the input
+// (or over the generated corpus when both are given) and prints one JSON record.
+// SPEC is comma-separated key=value: count, n, k, degree (default k-1), bits
+// (coefficient size), bases (colon list, e.g. 2:10:16), bad (corrupted shares
+// per object), prime (decimal; shares are then taken mod p), seed, reps.
+// Allocation counts cover operator new on this thread; arena-backed limbs are free.
+
+struct GenSpec {
+    int count = 100, n = 10, k = 4, degree = -1, bits = 128, bad = 0, reps = 1;
+    uint64_t seed = 1;
+    vector<int> bases{10};
+    cpp_int prime = 0;
+};
+
+bool parse_gen_spec(const string &text, GenSpec &spec, string &err) {
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        if (eq == string::npos) { err = "expected key=value: " + item; return false; }
+        string key = item.substr(0, eq), val = item.substr(eq + 1);
+        try {
+            if (key == "count") spec.count = stoi(val);
+            else if (key == "n") spec.n = stoi(val);
+            else if (key == "k") spec.k = stoi(val);
+            else if (key == "degree") spec.degree = stoi(val);
+            else if (key == "bits") spec.bits = stoi(val);
+            else if (key == "bad") spec.bad = stoi(val);
+            else if (key == "reps") spec.reps = stoi(val);
+            else if (key == "seed") spec.seed = stoull(val);
+            else if (key == "prime") spec.prime = parse_in_base_cpp(val, 10);
+            else if (key == "bases") {
+                spec.bases.clear();
+                stringstream bs(val);
+                string b;
+                while (getline(bs, b, ':')) spec.bases.push_back(stoi(b));
+            } else { err = "unknown key: " + key; return false; }
+        } catch (const exception &) {
+            err = "bad value for " + key + ": " + val;
+            return false;
+        }
+    }
+    if (spec.degree < 0) spec.degree = spec.k - 1;
+    if (spec.count < 0 || spec.n <= 0 || spec.k <= 0 || spec.bits <= 0 || spec.reps <= 0 || spec.bad < 0 ||
+        spec.bad > spec.n || spec.bases.empty()) {
+        err = "spec out of range";
+        return false;
+    }
+    for (int b : spec.bases)
+        if (b < 2 || b > 36) { err = "bases must be in 2..36"; return false; }
+    return true;
 }
 
-// ---------- Parse ints from a JSON-like substring (very targeted) ----------
-long long parse_small_int_after_key(const string &s, size_t pos_key) {
-    size_t p = s.find(':', pos_key);
-    if (p == string::npos) throw runtime_error("invalid json structure (int)");
-    ++p;
-    while (p < s.size() && isspace((unsigned char)s[p])) ++p;
-    size_t q = p;
-    while (q < s.size() && (s[q] == '-' || isdigit((unsigned char)s[q]))) ++q;
-    string num = s.substr(p, q - p);
-    trim(num);
-    return stoll(num);
+static cpp_int random_bits(mt19937_64 &rng, int bits) {
+    cpp_int v = 0;
+    for (int done = 0; done < bits; done += 64) {
+        uint64_t w = rng();
+        if (bits - done < 64) w &= (1ull << (bits - done)) - 1;
+        v |= cpp_int(w) << done;
+    }
+    return v;
 }
 
-// parse a quoted string value after key (e.g. "value": "abc")
-string parse_quoted_after_key(const string &s, size_t pos_key) {
-    size_t p = s.find(':', pos_key);
-    if (p == string::npos) throw runtime_error("invalid json structure (str)");
-    p++;
-    size_t q = s.find('"', p);
-    if (q == string::npos) throw runtime_error("invalid json: missing opening quote");
-    size_t r = s.find('"', q + 1);
-    if (r == string::npos) throw runtime_error("invalid json: missing closing quote");
-    return s.substr(q + 1, r - (q + 1));
+string generate_corpus(const GenSpec &spec) {
+    mt19937_64 rng(spec.seed);
+    string out = "[\n";
+    vector<cpp_int> coef(spec.degree + 1);
+    vector<int> idx(spec.n);
+    for (int o = 0; o < spec.count; ++o) {
+        for (cpp_int &c : coef) {
+            c = random_bits(rng, spec.bits);
+            if (spec.prime != 0) c %= spec.prime;
+        }
+        iota(idx.begin(), idx.end(), 0);
+        shuffle(idx.begin(), idx.end(), rng);
+        vector<bool> corrupt(spec.n, false);
+        for (int i = 0; i < spec.bad; ++i) corrupt[idx[i]] = true;
+
+        out += "  {\"keys\": {\"n\": " + to_string(spec.n) + ", \"k\": " + to_string(spec.k);
+        if (spec.prime != 0) out += ", \"prime\": \"" + cpp_int_to_string(spec.prime) + "\"";
+        out += "}";
+        for (int i = 0; i < spec.n; ++i) {
+            int x = i + 1;
+            cpp_int y = 0;
+            for (int m = spec.degree; m >= 0; --m) y = y * x + coef[m];
+            if (corrupt[i]) y += 1 + random_bits(rng, spec.bits);
+            if (spec.prime != 0) y %= spec.prime;
+            int base = spec.bases[rng() % spec.bases.size()];
+            out += ", \"" + to_string(x) + "\": {\"base\": \"" + to_string(base) + "\", \"value\": \"" +
+                   cpp_int_to_string(y, base) + "\"}";
+        }
+        out += o + 1 < spec.count ? "},\n" : "}\n";
+    }
+    out += "]\n";
+    return out;
 }
 
-// ---------- decode arbitrary-base string to cpp_int ----------
-cpp_int parse_in_base_cpp(const string &s_raw, int base) {
-    cpp_int val = 0;
-    for (char ch : s_raw) {
-        if (isspace((unsigned char)ch)) continue;
-        int d = -1;
-        if (ch >= '0' && ch <= '9') d = ch - '0';
-        else if (ch >= 'a' && ch <= 'z') d = ch - 'a' + 10;
-        else if (ch >= 'A' && ch <= 'Z') d = ch - 'A' + 10;
-        else throw runtime_error(string("invalid digit: ") + ch);
-        if (d < 0 || d >= base) throw runtime_error("digit >= base in parse_in_base_cpp");
-        val *= base;
-        val += d;
-    }
-    return val;
+static const char *engine_name(Engine e) {
+    switch (e) {
+    case Engine::Gauss: return "gauss";
+    case Engine::Bareiss: return "bareiss";
+    case Engine::Crt: return "crt";
+    case Engine::Lagrange: break;
+    }
+    return "lagrange";
 }
 
-// ---------- Extract JSON objects from input string ----------
-vector<string> split_json_objects(const string &input) {
-    vector<string> objs;
-    int depth = 0;
-    int start = -1;
-    for (size_t i = 0; i < input.size(); ++i) {
-        char c = input[i];
-        if (c == '{') {
-            if (depth == 0) start = (int)i;
-            depth++;
-        } else if (c == '}') {
-            depth--;
-            if (depth == 0 && start != -1) {
-                objs.push_back(input.substr(start, i - start + 1));
-                start = -1;
+// Stages: parse (tokenize the object; binary records skip it), decode (base
+// conversion of all shares, or the limb copy out of a binary record),
+// interpolate (one engine call on the first k shares; exact mode only), search
+// (the full subset search or decoder, which includes its own interpolations),
+// output (text of the constant).
+int run_bench(string_view input, const SolveOptions &opt, int reps) {
+    struct Stage {
+        const char *name;
+        uint64_t ops = 0, ns = 0, allocs = 0;
+    };
+    Stage stages[5] = {{"parse"}, {"decode"}, {"interpolate"}, {"search"}, {"output"}};
+    vector<string_view> objs = split_input(input);
+    if (objs.empty()) {
+        cerr << "No JSON objects found in input\n";
+        return 1;
+    }
+
+    uint64_t solved = 0, errors = 0;
+    auto timed = [&](Stage &st, auto &&fn) {
+        uint64_t a0 = StatCounters::local().allocs;
+        auto t0 = chrono::steady_clock::now();
+        auto r = fn();
+        st.ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        st.allocs += StatCounters::local().allocs - a0;
+        ++st.ops;
+        return r;
+    };
+    g_count_allocs = true;
+    for (int rep = 0; rep < reps; ++rep) {
+        for (string_view text : objs) {
+            try {
+                ParsedObject obj;
+                ShareSet set;
+                bool binary = is_binary_record(text);
+                if (!(binary || timed(stages[0], [&] { return parse_object(text, obj); })) ||
+                    !timed(stages[1], [&] { return binary ? decode_record(text, set) : decode_object(obj, set); })) {
+                    ++errors;
+                    continue;
+                }
+                if (set.prime == 0 && !opt.decode) {
+                    vector<int> xs(set.xs.begin(), set.xs.begin() + set.k);
+                    vector<cpp_int> ys(set.ys.begin(), set.ys.begin() + set.k);
+                    vector<Frac> coeffs;
+                    timed(stages[2], [&] { return interpolate_and_check(xs, ys, coeffs, opt); });
+                }
+                cpp_int constant;
+                vector<int> bad;
+                if (!timed(stages[3], [&] { return search_shares(set, constant, bad, opt); })) {
+                    ++errors;
+                    continue;
+                }
+                timed(stages[4], [&] { return format_result(constant, bad, opt).size(); });
+                ++solved;
+            } catch (const exception &) {
+                ++errors;
             }
         }
     }
-    return objs;
+    g_count_allocs = false;
+
+    cout << "{\"objects\": " << objs.size() << ", \"reps\": " << reps << ", \"engine\": \"" << engine_name(opt.engine)
+         << "\", \"search\": \"" << (opt.search == Search::Revolving ? "revolving" : "lex")
+         << "\", \"threads\": " << opt.threads << ", \"decode\": " << (opt.decode ? "true" : "false")
+         << ", \"solved\": " << solved << ", \"errors\": " << errors << ", \"stages\": {";
+    for (int i = 0; i < 5; ++i) {
+        const Stage &st = stages[i];
+        double ns = st.ops ? (double)st.ns / st.ops : 0, allocs = st.ops ? (double)st.allocs / st.ops : 0;
+        cout << (i ? ", " : "") << "\"" << st.name << "\": {\"ops\": " << st.ops << ", \"ns_per_op\": " << fixed
+             << setprecision(1) << ns << ", \"allocs_per_op\": " << allocs << "}";
+    }
+    cout << "}}\n";
+    return 0;
 }
 
-// ---------- Solve Vandermonde via Gaussian elimination ----------
-bool interpolate_and_check(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff) {
-    int k = xs.size();
-    vector<vector<Frac>> A(k, vector<Frac>(k + 1, Frac(0, 1)));
-    for (int i = 0; i < k; ++i) {
-        cpp_int power = 1;
-        for (int j = 0; j < k; ++j) {
-            A[i][j] = Frac(power, 1);
-            power *= xs[i];
+// ---------- Server mode ----------
+// --listen unix:PATH or tcp:[HOST:]PORT keeps one process, and with it the
+// weight cache, the chunk powers and every worker's arena, alive across
+// requests. A connection streams JSON objects (one per line or not) or a
+// binary share file, and every object is answered with "<seq> <result>", seq
+// counting that connection's objects from 0. Objects of all connections share
+// one pool of --jobs workers and answers are written as soon as they are
+// ready, so a client can keep many requests in flight and match them by seq.
+// A connection closes once its client has shut down writing and every answer
+// is out. Each connection has its own reader and writer thread, at most
+// SolveServer::kMaxConnections are served at once, and a client that leaves
+// its answers unread for kSendTimeoutSec is dropped. SIGINT / SIGTERM stop
+// accepting, finish the queued work and exit.
+static volatile sig_atomic_t g_stop = 0;
+
+extern "C" void on_stop_signal(int) { g_stop = 1; }
+
+class SolveServer {
+public:
+    static constexpr size_t kMaxConnections = 128;
+    static constexpr size_t kConnInFlight = 256; // answers a connection may have pending before its reader waits
+    static constexpr int kSendTimeoutSec = 30;   // a client that reads nothing for this long is dropped
+
+    SolveServer(const SolveOptions &opt, int workers) : opt_(opt), limit_(64 * (size_t)workers) {
+        for (int i = 0; i < workers; ++i) pool_.emplace_back([this] { work(); });
+    }
+    ~SolveServer() {
+        {
+            lock_guard<mutex> lock(mu_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+        for (auto &t : pool_) t.join();
+    }
+
+    // Accepts up to kMaxConnections connections at a time until a stop signal,
+    // then stops reading from every client and joins the connection threads
+    // once their answers are out; the destructor stops the workers.
+    void serve(int listen_fd) {
+        while (!g_stop) {
+            reap(false);
+            if (sessions_.size() >= kMaxConnections) { // leave further clients in the backlog
+                this_thread::sleep_for(chrono::milliseconds(50));
+                continue;
+            }
+            pollfd pfd{listen_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0) continue;
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) continue;
+            timeval tv{kSendTimeoutSec, 0};
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            auto conn = make_shared<Conn>(fd);
+            sessions_.push_back(Session{conn, thread([this, conn] { session(conn); })});
+        }
+        for (Session &s : sessions_) shutdown(s.conn->fd, SHUT_RD);
+        reap(true);
+    }
+
+private:
+    // One client. Workers only queue answers in outbox; the connection's own
+    // writer thread sends them, so a client that stops reading stalls nobody
+    // else. in_flight counts objects submitted but not yet answered on the wire.
+    struct Conn {
+        int fd;
+        mutex mu;
+        condition_variable cv;
+        deque<string> outbox;
+        size_t in_flight = 0;
+        bool reading = true, dead = false;
+        atomic<bool> finished{false};
+        explicit Conn(int f) : fd(f) {}
+        ~Conn() { close(fd); }
+
+        void reply(uint64_t seq, const string &text) {
+            lock_guard<mutex> lock(mu);
+            outbox.push_back(to_string(seq) + " " + text + "\n");
+            cv.notify_all();
+        }
+    };
+    struct Session {
+        shared_ptr<Conn> conn;
+        thread th;
+    };
+    struct Task {
+        shared_ptr<Conn> conn;
+        uint64_t seq;
+        string text;
+    };
+
+    // Joins finished connection threads, or all of them.
+    void reap(bool all) {
+        for (size_t i = 0; i < sessions_.size();) {
+            if (all || sessions_[i].conn->finished) {
+                sessions_[i].th.join();
+                sessions_[i] = move(sessions_.back());
+                sessions_.pop_back();
+            } else {
+                ++i;
+            }
         }
-        A[i][k] = Frac(ys[i], 1);
     }
 
-    for (int col = 0, row = 0; col < k && row < k; ++col, ++row) {
-        int sel = row;
-        for (int r = row; r < k; ++r) {
-            if (A[r][col].num != 0) { sel = r; break; }
+    void session(shared_ptr<Conn> conn) {
+        thread writer([this, conn] { write(*conn); });
+        read(conn);
+        {
+            lock_guard<mutex> lock(conn->mu);
+            conn->reading = false;
         }
-        if (A[sel][col].num == 0) return false;
-        if (sel != row) swap(A[sel], A[row]);
+        conn->cv.notify_all();
+        writer.join();
+        conn->finished = true;
+    }
 
-        Frac pivot = A[row][col];
-        for (int c = col; c <= k; ++c) A[row][c] = A[row][c] / pivot;
+    void read(const shared_ptr<Conn> &conn) {
+        int fd = conn->fd;
+        ObjectStream stream(
+            [fd](char *p, size_t n) {
+                ssize_t r;
+                do r = recv(fd, p, n, 0);
+                while (r < 0 && errno == EINTR);
+                return r > 0 ? (size_t)r : 0;
+            },
+            1 << 16);
+        string_view obj;
+        for (uint64_t seq = 0; stream.next(obj); ++seq) {
+            {
+                unique_lock<mutex> lock(conn->mu);
+                conn->cv.wait(lock, [&] { return conn->dead || conn->in_flight < kConnInFlight; });
+                if (conn->dead) return;
+                ++conn->in_flight;
+            }
+            submit(Task{conn, seq, string(obj)});
+        }
+    }
 
-        for (int r = 0; r < k; ++r) {
-            if (r == row) continue;
-            Frac factor = A[r][col];
-            if (factor.num == 0) continue;
-            for (int c = col; c <= k; ++c) {
-                A[r][c] = A[r][c] - factor * A[row][c];
+    // Sends queued answers until the reader is done and nothing is in flight.
+    // A failed or timed-out send drops the client: the rest of its answers are
+    // discarded and its reader is woken by the shutdown.
+    void write(Conn &conn) {
+        unique_lock<mutex> lock(conn.mu);
+        while (true) {
+            conn.cv.wait(lock, [&] { return !conn.outbox.empty() || (!conn.reading && conn.in_flight == 0); });
+            if (conn.outbox.empty()) return;
+            string line = move(conn.outbox.front());
+            conn.outbox.pop_front();
+            bool dead = conn.dead;
+            lock.unlock();
+            bool sent = !dead && send_all(conn.fd, line);
+            lock.lock();
+            --conn.in_flight;
+            if (!sent && !conn.dead) {
+                conn.dead = true;
+                shutdown(conn.fd, SHUT_RDWR);
             }
+            conn.cv.notify_all();
         }
     }
 
-    out_coeff.assign(k, Frac(0, 1));
-    for (int i = 0; i < k; ++i) out_coeff[i] = A[i][k];
+    static bool send_all(int fd, const string &line) {
+        for (size_t off = 0; off < line.size();) {
+            ssize_t w = send(fd, line.data() + off, line.size() - off, MSG_NOSIGNAL);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) return false; // client went away or read nothing for kSendTimeoutSec
+            off += (size_t)w;
+        }
+        return true;
+    }
 
-    // 🔴 FIX: allow negative or zero coefficients
-    for (int i = 0; i < k; ++i) {
-        if (!out_coeff[i].isInteger()) return false;
+    // Blocks while the queue is full, which pushes back on fast clients.
+    void submit(Task task) {
+        unique_lock<mutex> lock(mu_);
+        space_.wait(lock, [&] { return queue_.size() < limit_; });
+        queue_.push_back(move(task));
+        ready_.notify_one();
     }
-    return true;
-}
 
-// ---------- Iterate combinations ----------
-bool find_valid_constant(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k, cpp_int &constant_out) {
-    int n = (int)xs_full.size();
-    if (k > n) return false;
-
-    vector<int> choose(n, 0);
-    for (int i = 0; i < k; ++i) choose[i] = 1;
-    sort(choose.begin(), choose.end(), greater<int>());
-
-    do {
-        vector<int> xs;
-        vector<cpp_int> ys;
-        xs.reserve(k); ys.reserve(k);
-        for (int i = 0; i < n; ++i) if (choose[i]) { xs.push_back(xs_full[i]); ys.push_back(ys_full[i]); }
-        vector<Frac> coeffs;
-        bool ok = interpolate_and_check(xs, ys, coeffs);
-        if (ok) {
-            constant_out = coeffs[0].num;
-            return true;
+    void work() {
+        while (true) {
+            Task task;
+            {
+                unique_lock<mutex> lock(mu_);
+                ready_.wait(lock, [&] { return closed_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                task = move(queue_.front());
+                queue_.pop_front();
+            }
+            space_.notify_one();
+            string out;
+            bool ok = solve_or_error(task.text, out, opt_);
+            task.conn->reply(task.seq, ok || !out.empty() ? out : "ERROR");
         }
-    } while (prev_permutation(choose.begin(), choose.end()));
-    return false;
-}
+    }
 
-size_t find_key(const string &s, const string &key, size_t startpos = 0) {
-    return s.find(key, startpos);
+    const SolveOptions &opt_;
+    size_t limit_;
+    mutex mu_;
+    condition_variable ready_, space_;
+    deque<Task> queue_;
+    vector<thread> pool_;
+    vector<Session> sessions_; // touched by the serve thread only
+    bool closed_ = false;
+};
+
+// Binds spec (unix:PATH, tcp:PORT or tcp:HOST:PORT; the host defaults to
+// 127.0.0.1) and returns a listening socket, or -1 with err set.
+int open_listener(const string &spec, string &err) {
+    int fd = -1;
+    auto fail = [&](const string &what) {
+        err = what + ": " + strerror(errno);
+        if (fd >= 0) close(fd);
+        return -1;
+    };
+    if (spec.compare(0, 5, "unix:") == 0) {
+        string path = spec.substr(5);
+        sockaddr_un addr{};
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            err = "bad socket path: " + path;
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        struct stat st;
+        if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path.c_str()); // stale socket
+        if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return fail("socket");
+        if (bind(fd, (const sockaddr *)&addr, sizeof(addr)) != 0) return fail("bind " + path);
+    } else if (spec.compare(0, 4, "tcp:") == 0) {
+        string rest = spec.substr(4), host = "127.0.0.1", port = rest;
+        size_t colon = rest.rfind(':');
+        if (colon != string::npos) {
+            host = rest.substr(0, colon);
+            port = rest.substr(colon + 1);
+        }
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        if (int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &res); rc != 0) {
+            err = "cannot resolve " + rest + ": " + gai_strerror(rc);
+            return -1;
+        }
+        fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        int one = 1;
+        bool bound = fd >= 0 && setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+                     bind(fd, res->ai_addr, res->ai_addrlen) == 0;
+        freeaddrinfo(res);
+        if (!bound) return fail("bind " + rest);
+    } else {
+        err = "expected unix:PATH or tcp:[HOST:]PORT, got " + spec;
+        return -1;
+    }
+    if (listen(fd, 64) != 0) return fail("listen");
+    return fd;
 }
 
-string cpp_int_to_string(const cpp_int &v) {
-    string s;
-    cpp_int t = v;
-    if (t == 0) return "0";
-    bool neg = false;
-    if (t < 0) { neg = true; t = -t; }
-    while (t > 0) {
-        int digit = (int)(t % 10);
-        s.push_back(char('0' + digit));
-        t /= 10;
-    }
-    if (neg) s.push_back('-');
-    reverse(s.begin(), s.end());
-    return s;
+// Port actually bound, for the startup line (tcp:0 picks a free one).
+string listener_name(int fd, const string &spec) {
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    if (spec.compare(0, 4, "tcp:") != 0 || getsockname(fd, (sockaddr *)&addr, &len) != 0) return spec;
+    char host[NI_MAXHOST], port[NI_MAXSERV];
+    if (getnameinfo((sockaddr *)&addr, len, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV))
+        return spec;
+    return string("tcp:") + host + ":" + port;
 }
 
-// ---------- Parse one JSON ----------
-bool solve_one_json_string(const string &obj_str, string &out_constant_str) {
-    size_t pos_keys = obj_str.find("\"keys\"");
-    if (pos_keys == string::npos) return false;
-    size_t pos_n = obj_str.find("\"n\"", pos_keys);
-    size_t pos_k = obj_str.find("\"k\"", pos_keys);
-    if (pos_n == string::npos || pos_k == string::npos) return false;
-    long long n = parse_small_int_after_key(obj_str, pos_n);
-    long long k = parse_small_int_after_key(obj_str, pos_k);
-    if (n <= 0 || k <= 0) return false;
-
-    vector<int> xs;
-    vector<cpp_int> ys;
-    xs.reserve(n); ys.reserve(n);
-
-    for (long long idx = 1; idx <= n; ++idx) {
-        string key = "\"" + to_string(idx) + "\"";
-        size_t pos = obj_str.find(key);
-        if (pos == string::npos) continue;
-        size_t pos_base_key = obj_str.find("\"base\"", pos);
-        if (pos_base_key == string::npos) return false;
-        string base_str = parse_quoted_after_key(obj_str, pos_base_key);
-        int base = 10;
-        try {
-            base = stoi(base_str);
-        } catch (...) {
-            size_t colon = obj_str.find(':', pos_base_key);
-            if (colon == string::npos) return false;
-            size_t p = colon + 1; while (p < obj_str.size() && isspace((unsigned char)obj_str[p])) ++p;
-            size_t q = p; while (q < obj_str.size() && (isdigit((unsigned char)obj_str[q]) || obj_str[q] == '-')) ++q;
-            string num = obj_str.substr(p, q - p);
-            trim(num);
-            base = stoi(num);
-        }
-        size_t pos_val_key = obj_str.find("\"value\"", pos);
-        if (pos_val_key == string::npos) return false;
-        string val = parse_quoted_after_key(obj_str, pos_val_key);
-
-        cpp_int y = parse_in_base_cpp(val, base);
-        xs.push_back((int)idx);
-        ys.push_back(y);
-    }
-
-    if ((int)xs.size() < k) return false;
-
-    cpp_int constant;
-    bool found = find_valid_constant(xs, ys, (int)k, constant);
-    if (!found) return false;
-    out_constant_str = cpp_int_to_string(constant);
-    return true;
+int run_server(const string &spec, const SolveOptions &opt, int jobs) {
+    string err;
+    int fd = open_listener(spec, err);
+    if (fd < 0) {
+        cerr << err << "\n";
+        return 1;
+    }
+    struct sigaction sa{};
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    cerr << "Listening on " << listener_name(fd, spec) << "\n";
+    {
+        SolveServer server(opt, jobs);
+        server.serve(fd);
+    }
+    close(fd);
+    if (spec.compare(0, 5, "unix:") == 0) unlink(spec.c_str() + 5);
+    return 0;
 }
 
 // ---------- Main ----------
-int main() {
+int main(int argc, char **argv) {
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
 
-    string input;
-    {
-        ostringstream ss;
-        ss << cin.rdbuf();
-        input = ss.str();
+    SolveOptions opt;
+    int jobs = 1;
+    string path; // read this file via mmap instead of stdin
+    string cache_path, result_cache_path;
+    long long result_cache_cap = -1; // -1: default, on only with a cache file
+    string gen_spec;
+    string listen_spec;
+    bool bench = false, to_binary = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--engine" && i + 1 < argc) {
+            string e = argv[++i];
+            opt.fixed_tier = false;
+            if (e == "lagrange") opt.engine = Engine::Lagrange;
+            else if (e == "gauss") opt.engine = Engine::Gauss;
+            else if (e == "bareiss") opt.engine = Engine::Bareiss;
+            else if (e == "crt") opt.engine = Engine::Crt;
+            else { cerr << "Unknown engine: " << e << "\n"; return 1; }
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = max(1, atoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            opt.threads = max(1, atoi(argv[++i]));
+        } else if (arg == "--out-base" && i + 1 < argc) {
+            opt.out_base = atoi(argv[++i]);
+            if (opt.out_base < 2 || opt.out_base > 36) { cerr << "Output base must be in 2..36\n"; return 1; }
+        } else if (arg == "--weight-cache" && i + 1 < argc) {
+            LagrangeWeightCache::global().set_capacity(max(0, atoi(argv[++i])));
+        } else if (arg == "--weight-cache-file" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--result-cache" && i + 1 < argc) {
+            result_cache_cap = max(0, atoi(argv[++i]));
+        } else if (arg == "--result-cache-file" && i + 1 < argc) {
+            result_cache_path = argv[++i];
+        } else if (arg == "--consensus" && i + 1 < argc) {
+            opt.consensus = max(0, atoi(argv[++i]));
+        } else if (arg == "--gen" && i + 1 < argc) {
+            gen_spec = argv[++i];
+        } else if (arg == "--time-limit" && i + 1 < argc) {
+            opt.time_limit_ms = max(0.0, atof(argv[++i]));
+        } else if (arg == "--max-combos" && i + 1 < argc) {
+            opt.max_combos = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--stats") {
+            g_stats_enabled = g_count_allocs = true;
+        } else if (arg == "--bench") {
+            bench = true;
+        } else if (arg == "--listen" && i + 1 < argc) {
+            listen_spec = argv[++i];
+        } else if (arg == "--to-binary") {
+            to_binary = true;
+        } else if (arg == "--decode") {
+            opt.decode = true;
+        } else if (arg == "--prune") {
+            opt.prune = true;
+        } else if (arg == "--search" && i + 1 < argc) {
+            string o = argv[++i];
+            if (o == "lex") opt.search = Search::Lex;
+            else if (o == "revolving") opt.search = Search::Revolving;
+            else { cerr << "Unknown search order: " << o << "\n"; return 1; }
+        } else if (arg.size() < 2 || arg.compare(0, 2, "--") != 0) {
+            path = arg;
+        } else {
+            cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
     }
-    if (input.empty()) {
-        cerr << "No input provided\n";
-        return 1;
+
+    if (!gen_spec.empty() || bench) {
+        GenSpec spec;
+        string err;
+        if (!parse_gen_spec(gen_spec, spec, err)) { cerr << "Bad --gen spec: " << err << "\n"; return 1; }
+        if (!gen_spec.empty() && !bench) {
+            cout << (to_binary ? json_to_binary(generate_corpus(spec)) : generate_corpus(spec));
+            return 0;
+        }
+        string input;
+        if (!gen_spec.empty()) {
+            input = generate_corpus(spec);
+        } else if (!path.empty()) {
+            try {
+                MappedFile file(path);
+                input.assign(file.view());
+            } catch (const exception &e) {
+                cerr << e.what() << "\n";
+                return 1;
+            }
+        } else {
+            input.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        }
+        return run_bench(input, opt, spec.reps);
     }
 
-    vector<string> objects = split_json_objects(input);
-    if (objects.empty()) {
-        cerr << "No JSON objects found in input\n";
-        return 1;
+    if (to_binary) {
+        string input;
+        if (!path.empty()) {
+            try {
+                MappedFile file(path);
+                input.assign(file.view());
+            } catch (const exception &e) {
+                cerr << e.what() << "\n";
+                return 1;
+            }
+        } else {
+            input.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        }
+        cout << json_to_binary(input);
+        return 0;
     }
 
+    if (!cache_path.empty() && !LagrangeWeightCache::global().load(cache_path))
+        cerr << "Ignoring malformed weight cache: " << cache_path << "\n";
+    ResultCache &results = ResultCache::global();
+    results.set_capacity(result_cache_cap >= 0 ? (size_t)result_cache_cap : result_cache_path.empty() ? 0 : 65536);
+    if (!result_cache_path.empty() && results.capacity() > 0 && !results.load(result_cache_path))
+        cerr << "Dropped corrupted entries of result cache: " << result_cache_path << "\n";
+    struct CacheSaver { // runs on every return below
+        const string &path, &result_path;
+        ~CacheSaver() {
+            if (!path.empty() && !LagrangeWeightCache::global().save(path))
+                cerr << "Could not write weight cache: " << path << "\n";
+            if (!result_path.empty() && ResultCache::global().capacity() > 0 && !ResultCache::global().save(result_path))
+                cerr << "Could not write result cache: " << result_path << "\n";
+        }
+    } saver{cache_path, result_cache_path};
+
+    if (!listen_spec.empty()) return run_server(listen_spec, opt, jobs);
+
+    StatsReport report;
+    StatsReport *stats = g_stats_enabled ? &report : nullptr;
+    uint64_t split_ns = 0;
+    struct StatsFinisher { // runs on every return below
+        StatsReport *stats;
+        const uint64_t &split_ns;
+        ~StatsFinisher() {
+            if (stats) stats->finish(split_ns);
+        }
+    } stats_finisher{stats, split_ns};
+    auto split_clock = [&](auto &&fn) {
+        if (!stats) return fn();
+        auto t0 = chrono::steady_clock::now();
+        auto r = fn();
+        split_ns += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        return r;
+    };
+
+    size_t objects = 0;
     bool anyPrinted = false;
-    for (auto &obj : objects) {
+    auto print_one = [&](string_view obj) {
+        ++objects;
         string cstr;
-        bool ok = solve_one_json_string(obj, cstr);
+        StatCounters obj_stats;
+        bool ok = stats ? solve_counted(obj, cstr, opt, obj_stats) : solve_or_error(obj, cstr, opt);
+        if (stats) stats->object(ok, obj_stats);
         if (ok) {
             cout << cstr << "\n";
             anyPrinted = true;
         } else {
-            cout << "ERROR\n";
+            cout << (cstr.empty() ? "ERROR" : cstr) << "\n";
         }
+    };
+
+    // Whole inputs in memory: objects and binary records are views into them.
+    auto solve_all = [&](string_view input) {
+        if (input.empty()) {
+            cerr << "No input provided\n";
+            return 1;
+        }
+        vector<string_view> views = split_clock([&] { return split_input(input); });
+        if (views.empty()) {
+            cerr << (is_binary_shares(input) ? "No records found in input\n" : "No JSON objects found in input\n");
+            return 1;
+        }
+        if (jobs > 1) {
+            BatchRunner runner(opt, jobs, 32 * (size_t)jobs, stats);
+            for (string_view obj : views) runner.submit(obj);
+            runner.finish();
+            return runner.any_printed() ? 0 : 1;
+        }
+        for (string_view obj : views) print_one(obj);
+        return anyPrinted ? 0 : 1;
+    };
+
+    if (!path.empty()) { // zero-copy: objects are views into the mapping
+        unique_ptr<MappedFile> file;
+        try {
+            file = make_unique<MappedFile>(path);
+        } catch (const exception &e) {
+            cerr << e.what() << "\n";
+            return 1;
+        }
+        return solve_all(file->view());
+    }
+    ObjectStream stream(cin);
+    string_view obj;
+    if (jobs > 1) {
+        BatchRunner runner(opt, jobs, 32 * (size_t)jobs, stats);
+        while (split_clock([&] { return stream.next(obj); })) {
+            runner.submit(obj, true);
+            ++objects;
+        }
+        runner.finish();
+        anyPrinted = runner.any_printed();
+    } else {
+        while (split_clock([&] { return stream.next(obj); })) print_one(obj);
+    }
+    if (stream.bytes_read() == 0) {
+        cerr << "No input provided\n";
+        return 1;
+    }
+    if (objects == 0) {
+        cerr << "No JSON objects found in input\n";
+        return 1;
     }
 
     return anyPrinted ? 0 : 1;
 }
+
@@ -0,0 +1,3070 @@
+// shamir_core.hpp
+// Header-only numeric core of shamir_verify: exact interpolation engines over Q,
+// GF(p) reconstruction, subset searches, Reed-Solomon decoding and radix
+// conversion, plus the reusable ShamirSolver context. No I/O; the JSON front
+// end lives in shamir_parse.hpp. Everything is in namespace shamir.
+#pragma once
+
+#include <bits/stdc++.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/multiprecision/miller_rabin.hpp>
+
+namespace shamir {
+using namespace std;
+using boost::multiprecision::cpp_int;
+
+// ---------- Stats counters ----------
+// --stats keeps per-thread counters; searches that spawn workers merge theirs
+// back after joining. Everything is behind g_stats_enabled / g_count_allocs,
+// which are set before any thread starts, so the default path only pays for
+// a predictable branch.
+inline bool g_stats_enabled = false;
+inline bool g_count_allocs = false;
+
+struct StatCounters {
+    uint64_t parse_ns = 0, decode_ns = 0, search_ns = 0, interp_ns = 0;
+    uint64_t interp_calls = 0, combos_tried = 0, combos_total = 0; // combos_total saturates
+    uint64_t peak_bits = 0, allocs = 0, result_hits = 0;
+
+    static StatCounters &local() {
+        static thread_local StatCounters c;
+        return c;
+    }
+    void merge(const StatCounters &o) {
+        parse_ns += o.parse_ns; decode_ns += o.decode_ns; search_ns += o.search_ns; interp_ns += o.interp_ns;
+        interp_calls += o.interp_calls; combos_tried += o.combos_tried;
+        combos_total = o.combos_total > UINT64_MAX - combos_total ? UINT64_MAX : combos_total + o.combos_total;
+        peak_bits = max(peak_bits, o.peak_bits);
+        allocs += o.allocs;
+        result_hits += o.result_hits;
+    }
+};
+
+// Adds the scope's wall time to one StatCounters field of this thread.
+class StatTimer {
+public:
+    explicit StatTimer(uint64_t StatCounters::*field) : field_(g_stats_enabled ? field : nullptr) {
+        if (field_) t0_ = chrono::steady_clock::now();
+    }
+    ~StatTimer() {
+        if (field_)
+            StatCounters::local().*field_ +=
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0_).count();
+    }
+
+private:
+    uint64_t StatCounters::*field_;
+    chrono::steady_clock::time_point t0_;
+};
+
+template <class I>
+inline void stat_bits(const I &v) {
+    if (!g_stats_enabled || v == 0) return;
+    uint64_t b = msb(v < 0 ? I(-v) : v) + 1;
+    uint64_t &peak = StatCounters::local().peak_bits;
+    if (b > peak) peak = b;
+}
+
+// C(n, k), saturated at UINT64_MAX.
+inline uint64_t binom_saturated(int n, int k) {
+    if (k < 0 || k > n) return 0;
+    uint64_t c = 1;
+    for (int i = 1; i <= k && c != UINT64_MAX; ++i) {
+        unsigned __int128 next = (unsigned __int128)c * (n - k + i) / i;
+        c = next > UINT64_MAX ? UINT64_MAX : (uint64_t)next;
+    }
+    return c;
+}
+
+inline void stat_combos(int n, int k) {
+    if (!g_stats_enabled) return;
+    uint64_t c = binom_saturated(n, k);
+    StatCounters &s = StatCounters::local();
+    s.combos_total = c > UINT64_MAX - s.combos_total ? UINT64_MAX : s.combos_total + c;
+}
+
+inline void stat_combo_tried() {
+    if (g_stats_enabled) ++StatCounters::local().combos_tried;
+}
+
+
+// ---------- Fraction with cpp_int ----------
+struct Frac {
+    cpp_int num;
+    cpp_int den; // always > 0
+    Frac(cpp_int n = 0, cpp_int d = 1) {
+        if (d == 0) throw runtime_error("zero denominator");
+        if (d < 0) { n = -n; d = -d; }
+        stat_bits(n);
+        stat_bits(d);
+        if (d == 1) { num = std::move(n); den = std::move(d); return; }
+        cpp_int g = boost::multiprecision::gcd(n, d);
+        num = n / g; den = d / g;
+    }
+    Frac operator+(const Frac &o) const { return Frac(num * o.den + o.num * den, den * o.den); }
+    Frac operator-(const Frac &o) const { return Frac(num * o.den - o.num * den, den * o.den); }
+    Frac operator*(const Frac &o) const { return Frac(num * o.num, den * o.den); }
+    Frac operator/(const Frac &o) const {
+        if (o.num == 0) throw runtime_error("division by zero fraction");
+        return Frac(num * o.den, den * o.num);
+    }
+    bool isInteger() const { return den == 1; }
+};
+
+// ---------- Arena-backed lazy fractions ----------
+// Per-thread bump arena for big-integer limbs. An ArenaScope releases
+// everything allocated since it was opened; frees of the most recent block roll
+// the top back, other frees are no-ops until the scope closes. Outside any scope
+// (or past kCap) allocations go to the heap, so stray values stay valid.
+class LimbArena {
+public:
+    static LimbArena &local() { static thread_local LimbArena a; return a; }
+
+    void *allocate(size_t bytes) {
+        bytes = (bytes + 15) & ~size_t(15);
+        if (depth_ == 0) return ::operator new(bytes);
+        while (cur_ < blocks_.size() && blocks_[cur_].used + bytes > blocks_[cur_].size) {
+            if (cur_ + 1 == blocks_.size()) break;
+            blocks_[++cur_].used = 0;
+        }
+        if (cur_ >= blocks_.size() || blocks_[cur_].used + bytes > blocks_[cur_].size) {
+            size_t sz = max<size_t>(bytes, blocks_.empty() ? kFirst : blocks_.back().size * 2);
+            if (total_ + sz > kCap) return ::operator new(bytes);
+            blocks_.push_back({unique_ptr<char[]>(new char[sz]), sz, 0});
+            total_ += sz;
+            cur_ = blocks_.size() - 1;
+        }
+        Block &b = blocks_[cur_];
+        void *p = b.mem.get() + b.used;
+        b.used += bytes;
+        return p;
+    }
+    void deallocate(void *p, size_t bytes) {
+        bytes = (bytes + 15) & ~size_t(15);
+        char *c = static_cast<char *>(p);
+        for (const Block &b : blocks_)
+            if (c >= b.mem.get() && c < b.mem.get() + b.size) {
+                Block &top = blocks_[cur_];
+                if (c + bytes == top.mem.get() + top.used) top.used -= bytes;
+                return;
+            }
+        ::operator delete(p);
+    }
+
+private:
+    friend class ArenaScope;
+    struct Block { unique_ptr<char[]> mem; size_t size, used; };
+    static constexpr size_t kFirst = 1 << 16, kCap = size_t(1) << 28;
+    vector<Block> blocks_;
+    size_t cur_ = 0, total_ = 0;
+    int depth_ = 0;
+};
+
+class ArenaScope {
+public:
+    ArenaScope() : a_(LimbArena::local()), cur_(a_.cur_), used_(a_.blocks_.empty() ? 0 : a_.blocks_[a_.cur_].used) {
+        ++a_.depth_;
+    }
+    ~ArenaScope() {
+        --a_.depth_;
+        if (a_.blocks_.empty()) return;
+        a_.cur_ = cur_;
+        a_.blocks_[cur_].used = used_;
+    }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    LimbArena &a_;
+    size_t cur_, used_;
+};
+
+template <class T>
+struct ArenaAlloc {
+    using value_type = T;
+    ArenaAlloc() = default;
+    template <class U> ArenaAlloc(const ArenaAlloc<U> &) {}
+    T *allocate(size_t n) { return static_cast<T *>(LimbArena::local().allocate(n * sizeof(T))); }
+    void deallocate(T *p, size_t n) { LimbArena::local().deallocate(p, n * sizeof(T)); }
+    template <class U> bool operator==(const ArenaAlloc<U> &) const { return true; }
+    template <class U> bool operator!=(const ArenaAlloc<U> &) const { return false; }
+};
+
+using arena_int = boost::multiprecision::number<boost::multiprecision::cpp_int_backend<
+    0, 0, boost::multiprecision::signed_magnitude, boost::multiprecision::unchecked,
+    ArenaAlloc<boost::multiprecision::limb_type>>>;
+
+// Rational with den > 0 that is reduced only when its denominator has doubled
+// in size since the last reduction, or when a caller needs canonical form.
+// Operations are in place; sub_mul fuses a -= f * b without temporaries.
+struct LazyFrac {
+    arena_int num, den;
+    unsigned norm_bits = 0;
+
+    LazyFrac() : num(0), den(1) {}
+    template <class I> explicit LazyFrac(const I &n) : num(n), den(1) {}
+
+    bool is_zero() const { return num == 0; }
+    bool is_integer() const { return den == 1 || num % den == 0; }
+
+    void normalize() {
+        if (den == 1) { norm_bits = 0; return; }
+        arena_int g = boost::multiprecision::gcd(num, den);
+        if (g != 1) { num /= g; den /= g; }
+        norm_bits = den == 1 ? 0 : (unsigned)msb(den);
+    }
+    void maybe_normalize() {
+        stat_bits(num);
+        stat_bits(den);
+        if (den != 1 && msb(den) > 2 * norm_bits + 64) normalize();
+    }
+
+    // this /= o, o nonzero
+    void div(const LazyFrac &o) {
+        num *= o.den;
+        den *= o.num;
+        if (den < 0) { num = -num; den = -den; }
+        maybe_normalize();
+    }
+    // this -= f * b
+    void sub_mul(const LazyFrac &f, const LazyFrac &b) {
+        if (f.den == 1 && b.den == 1 && den == 1) {
+            num -= f.num * b.num;
+            return;
+        }
+        tmp_ = f.num * b.num;
+        tmp_ *= den;
+        num *= f.den;
+        num *= b.den;
+        num -= tmp_;
+        den *= f.den;
+        den *= b.den;
+        maybe_normalize();
+    }
+
+private:
+    arena_int tmp_;
+};
+
+// Row-major rows x cols block in the limb arena (the element array and the
+// limbs behind it), addressed through a row-permutation index so pivoting
+// swaps two ints instead of two rows. row(r) is contiguous, so a kernel walks
+// a row with plain pointer increments.
+template <class T>
+class FlatMatrix {
+public:
+    FlatMatrix(int rows, int cols) : cols_(cols), cells_((size_t)rows * cols), perm_(rows) {
+        iota(perm_.begin(), perm_.end(), 0);
+    }
+    T *row(int r) { return cells_.data() + (size_t)perm_[r] * cols_; }
+    T &at(int r, int c) { return row(r)[c]; }
+    void swap_rows(int a, int b) { swap(perm_[a], perm_[b]); }
+
+private:
+    int cols_;
+    vector<T, ArenaAlloc<T>> cells_;
+    vector<int> perm_;
+};
+
+// ---------- Prime fields ----------
+// Montgomery arithmetic on L fixed 64-bit limbs (CIOS multiplication), so no
+// element ever touches the heap. Requires an odd modulus below 2^(64L).
+template <size_t L>
+struct MontField {
+    using elem = array<uint64_t, L>;
+    elem p{}, r2{}, one_m{};
+    uint64_t pinv = 0; // -p^-1 mod 2^64
+    cpp_int p_big;
+
+    explicit MontField(const cpp_int &prime) : p_big(prime) {
+        p = to_limbs(prime);
+        uint64_t inv = 1;
+        for (int i = 0; i < 6; ++i) inv *= 2 - p[0] * inv;
+        pinv = 0 - inv;
+        cpp_int R = cpp_int(1) << (64 * L);
+        r2 = to_limbs((R * R) % prime);
+        one_m = to_limbs(R % prime);
+    }
+    static elem to_limbs(const cpp_int &v) {
+        elem out{};
+        cpp_int t = v;
+        for (size_t i = 0; i < L && t != 0; ++i) {
+            out[i] = (uint64_t)(t & 0xFFFFFFFFFFFFFFFFull);
+            t >>= 64;
+        }
+        return out;
+    }
+    static bool geq(const elem &a, const elem &b) {
+        for (size_t i = L; i-- > 0;) if (a[i] != b[i]) return a[i] > b[i];
+        return true;
+    }
+    static uint64_t sub_in_place(elem &a, const elem &b) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < L; ++i) {
+            unsigned __int128 d = (unsigned __int128)a[i] - b[i] - borrow;
+            a[i] = (uint64_t)d;
+            borrow = (uint64_t)(d >> 64) & 1;
+        }
+        return borrow;
+    }
+
+    elem zero() const { return elem{}; }
+    elem one() const { return one_m; }
+    bool is_zero(const elem &a) const {
+        for (uint64_t w : a) if (w) return false;
+        return true;
+    }
+    elem add(const elem &a, const elem &b) const {
+        elem s;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < L; ++i) {
+            unsigned __int128 t = (unsigned __int128)a[i] + b[i] + carry;
+            s[i] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        if (carry || geq(s, p)) sub_in_place(s, p);
+        return s;
+    }
+    elem sub(const elem &a, const elem &b) const {
+        elem d = a;
+        if (sub_in_place(d, b)) {
+            uint64_t carry = 0;
+            for (size_t i = 0; i < L; ++i) {
+                unsigned __int128 t = (unsigned __int128)d[i] + p[i] + carry;
+                d[i] = (uint64_t)t;
+                carry = (uint64_t)(t >> 64);
+            }
+        }
+        return d;
+    }
+    elem neg(const elem &a) const { return sub(zero(), a); }
+    elem mul(const elem &a, const elem &b) const {
+        uint64_t t[L + 2] = {};
+        for (size_t i = 0; i < L; ++i) {
+            uint64_t c = 0;
+            for (size_t j = 0; j < L; ++j) {
+                unsigned __int128 x = (unsigned __int128)a[j] * b[i] + t[j] + c;
+                t[j] = (uint64_t)x;
+                c = (uint64_t)(x >> 64);
+            }
+            unsigned __int128 x = (unsigned __int128)t[L] + c;
+            t[L] = (uint64_t)x;
+            t[L + 1] = (uint64_t)(x >> 64);
+            uint64_t m = t[0] * pinv;
+            x = (unsigned __int128)m * p[0] + t[0];
+            c = (uint64_t)(x >> 64);
+            for (size_t j = 1; j < L; ++j) {
+                x = (unsigned __int128)m * p[j] + t[j] + c;
+                t[j - 1] = (uint64_t)x;
+                c = (uint64_t)(x >> 64);
+            }
+            x = (unsigned __int128)t[L] + c;
+            t[L - 1] = (uint64_t)x;
+            t[L] = t[L + 1] + (uint64_t)(x >> 64);
+        }
+        elem r;
+        for (size_t i = 0; i < L; ++i) r[i] = t[i];
+        if (t[L] || geq(r, p)) sub_in_place(r, p);
+        return r;
+    }
+    elem from_big(const cpp_int &v) const {
+        cpp_int t = v % p_big;
+        if (t < 0) t += p_big;
+        return mul(to_limbs(t), r2);
+    }
+    // any v < 2^64 works: a*r2 < R*p keeps the CIOS result below 2p
+    elem from_word(uint64_t v) const {
+        elem t{};
+        t[0] = v;
+        return mul(t, r2);
+    }
+    elem from_int(long long v) const {
+        return v < 0 ? neg(from_word(0 - (uint64_t)v)) : from_word((uint64_t)v);
+    }
+    cpp_int to_big(const elem &a) const {
+        elem one_plain{};
+        one_plain[0] = 1;
+        elem r = mul(a, one_plain);
+        cpp_int v = 0;
+        for (size_t i = L; i-- > 0;) { v <<= 64; v += r[i]; }
+        return v;
+    }
+    uint64_t to_word(const elem &a) const { // only meaningful for single-limb moduli
+        elem one_plain{};
+        one_plain[0] = 1;
+        return mul(a, one_plain)[0];
+    }
+    elem inv(const elem &a) const { // Fermat: a^(p-2)
+        cpp_int e = p_big - 2;
+        elem r = one_m;
+        for (unsigned b = (unsigned)msb(e) + 1; b-- > 0;) {
+            r = mul(r, r);
+            if (bit_test(e, b)) r = mul(r, a);
+        }
+        return r;
+    }
+};
+
+// Generic fallback for moduli that do not fit a fixed-width specialization.
+struct BigField {
+    using elem = cpp_int;
+    cpp_int p_big;
+    explicit BigField(const cpp_int &prime) : p_big(prime) {}
+    elem zero() const { return 0; }
+    elem one() const { return 1 % p_big; }
+    bool is_zero(const elem &a) const { return a == 0; }
+    elem add(const elem &a, const elem &b) const { elem s = a + b; if (s >= p_big) s -= p_big; return s; }
+    elem sub(const elem &a, const elem &b) const { elem d = a - b; if (d < 0) d += p_big; return d; }
+    elem neg(const elem &a) const { return sub(0, a); }
+    elem mul(const elem &a, const elem &b) const { return (a * b) % p_big; }
+    elem from_big(const cpp_int &v) const { elem t = v % p_big; if (t < 0) t += p_big; return t; }
+    elem from_int(long long v) const { return from_big(cpp_int(v)); }
+    cpp_int to_big(const elem &a) const { return a; }
+    elem inv(const elem &a) const { return powm(a, p_big - 2, p_big); }
+};
+
+// Compile-time choice of field type for the common curve-sized primes.
+template <unsigned Bits> struct FieldFor { using type = BigField; };
+template <> struct FieldFor<256> { using type = MontField<4>; };
+template <> struct FieldFor<521> { using type = MontField<9>; };
+
+// Replaces each entry by its inverse with a single field inversion; false if any is zero.
+template <class F>
+bool batch_invert(const F &f, vector<typename F::elem> &v) {
+    using E = typename F::elem;
+    int k = v.size();
+    vector<E> prefix(k + 1, f.one());
+    for (int i = 0; i < k; ++i) {
+        if (f.is_zero(v[i])) return false;
+        prefix[i + 1] = f.mul(prefix[i], v[i]);
+    }
+    E inv_all = f.inv(prefix[k]);
+    for (int i = k - 1; i >= 0; --i) {
+        E inv_i = f.mul(inv_all, prefix[i]);
+        inv_all = f.mul(inv_all, v[i]);
+        v[i] = inv_i;
+    }
+    return true;
+}
+
+// ---------- Word-sized primes for multi-modular arithmetic ----------
+using WordField = MontField<1>;
+
+inline uint64_t mulmod_u64(uint64_t a, uint64_t b, uint64_t m) { return (uint64_t)((unsigned __int128)a * b % m); }
+
+inline bool is_prime_u64(uint64_t n) {
+    if (n < 2) return false;
+    for (uint64_t q : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) if (n % q == 0) return n == q;
+    uint64_t d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) { d >>= 1; ++s; }
+    for (uint64_t a : {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37}) { // deterministic below 2^64
+        uint64_t x = 1, b = a, e = d;
+        for (; e; e >>= 1, b = mulmod_u64(b, b, n)) if (e & 1) x = mulmod_u64(x, b, n);
+        if (x == 1 || x == n - 1) continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; ++r) {
+            x = mulmod_u64(x, x, n);
+            if (x == n - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+// The idx-th prime below 2^62, generated on demand. All of them exceed 2^32, so
+// every difference of two int share indices is a unit modulo each one.
+inline const WordField &word_prime(size_t idx) {
+    static mutex mu;
+    static deque<WordField> primes; // deque: references survive growth
+    static uint64_t candidate = (1ull << 62) - 1;
+    lock_guard<mutex> lock(mu);
+    while (primes.size() <= idx) {
+        while (!is_prime_u64(candidate)) candidate -= 2;
+        primes.emplace_back(cpp_int(candidate));
+        candidate -= 2;
+    }
+    return primes[idx];
+}
+
+// ---------- Polynomials over a prime field ----------
+// Coefficient vectors, lowest degree first; an empty vector is the zero polynomial.
+template <class F, class E = typename F::elem>
+void poly_trim(const F &f, vector<E> &a) {
+    while (!a.empty() && f.is_zero(a.back())) a.pop_back();
+}
+
+template <class F, class E = typename F::elem>
+vector<E> poly_mul(const F &f, const vector<E> &a, const vector<E> &b) {
+    if (a.empty() || b.empty()) return {};
+    vector<E> c(a.size() + b.size() - 1, f.zero());
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j) c[i + j] = f.add(c[i + j], f.mul(a[i], b[j]));
+    poly_trim(f, c);
+    return c;
+}
+
+template <class F, class E = typename F::elem>
+vector<E> poly_sub(const F &f, const vector<E> &a, const vector<E> &b) {
+    vector<E> c(max(a.size(), b.size()), f.zero());
+    for (size_t i = 0; i < a.size(); ++i) c[i] = a[i];
+    for (size_t i = 0; i < b.size(); ++i) c[i] = f.sub(c[i], b[i]);
+    poly_trim(f, c);
+    return c;
+}
+
+// a = q * b + r with deg r < deg b; b must be nonzero.
+template <class F, class E = typename F::elem>
+void poly_divmod(const F &f, const vector<E> &a, const vector<E> &b, vector<E> &q, vector<E> &r) {
+    r = a;
+    poly_trim(f, r);
+    if (r.size() < b.size()) { q.clear(); return; }
+    q.assign(r.size() - b.size() + 1, f.zero());
+    E lead_inv = f.inv(b.back());
+    for (size_t i = q.size(); i-- > 0;) {
+        E c = f.mul(r[i + b.size() - 1], lead_inv);
+        q[i] = c;
+        if (f.is_zero(c)) continue;
+        for (size_t j = 0; j < b.size(); ++j) r[i + j] = f.sub(r[i + j], f.mul(c, b[j]));
+    }
+    r.resize(b.size() - 1);
+    poly_trim(f, r);
+    poly_trim(f, q);
+}
+
+template <class F, class E = typename F::elem>
+E poly_eval(const F &f, const vector<E> &a, const E &x) {
+    E acc = f.zero();
+    for (size_t i = a.size(); i-- > 0;) acc = f.add(f.mul(acc, x), a[i]);
+    return acc;
+}
+
+// ---------- Fast polynomial arithmetic ----------
+// For large k the quadratic routines give way to subproduct trees. Products use
+// Karatsuba and remainders use a Newton inverse of the reversed divisor, so
+// interpolation and multipoint evaluation cost O(M(k) log k) with
+// M(k) ~ k^1.58. There is no NTT: neither the word primes nor user primes are
+// NTT-friendly, and Karatsuba works the same in every field type.
+constexpr size_t kKaratsubaMin = 32;
+constexpr size_t kTreeLeafBlock = 128;
+constexpr int kTreeInterpolationMin = 512; // measured crossover with the O(k^2) loop
+
+// out[0 .. 2n-2] = a[0 .. n-1] * b[0 .. n-1]. z0 and z2 are written straight
+// into out; the middle product and the recursion share scratch of 8n elements.
+template <class F, class E = typename F::elem>
+void kara_mul(const F &f, const E *a, const E *b, size_t n, E *out, E *scratch) {
+    if (n <= kKaratsubaMin) {
+        fill(out, out + 2 * n - 1, f.zero());
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j) out[i + j] = f.add(out[i + j], f.mul(a[i], b[j]));
+        return;
+    }
+    size_t h = n / 2, hi = n - h; // a = a0 + x^h a1 with |a0| = h, |a1| = hi >= h
+    E *sa = scratch, *sb = sa + hi, *z1 = sb + hi, *rest = z1 + 2 * hi;
+    for (size_t i = 0; i < hi; ++i) {
+        sa[i] = i < h ? f.add(a[i], a[h + i]) : a[h + i];
+        sb[i] = i < h ? f.add(b[i], b[h + i]) : b[h + i];
+    }
+    kara_mul(f, a, b, h, out, rest);
+    out[2 * h - 1] = f.zero();
+    kara_mul(f, a + h, b + h, hi, out + 2 * h, rest);
+    kara_mul(f, sa, sb, hi, z1, rest);
+    for (size_t i = 0; i + 1 < 2 * hi; ++i) {
+        z1[i] = f.sub(z1[i], out[2 * h + i]);
+        if (i + 1 < 2 * h) z1[i] = f.sub(z1[i], out[i]);
+    }
+    for (size_t i = 0; i + 1 < 2 * hi; ++i) out[h + i] = f.add(out[h + i], z1[i]);
+}
+
+// poly_mul for long operands; the longer one is cut into pieces of the shorter's length.
+template <class F, class E = typename F::elem>
+vector<E> poly_mul_fast(const F &f, const vector<E> &a, const vector<E> &b) {
+    if (a.size() < b.size()) return poly_mul_fast(f, b, a);
+    size_t n = b.size();
+    if (n <= kKaratsubaMin) return poly_mul(f, a, b);
+    vector<E> c(a.size() + n - 1, f.zero()), piece(n), prod(2 * n - 1), scratch(8 * n);
+    for (size_t off = 0; off < a.size(); off += n) {
+        size_t len = min(n, a.size() - off);
+        copy(a.begin() + off, a.begin() + off + len, piece.begin());
+        fill(piece.begin() + len, piece.end(), f.zero());
+        kara_mul(f, piece.data(), b.data(), n, prod.data(), scratch.data());
+        for (size_t i = 0; i < prod.size() && off + i < c.size(); ++i) c[off + i] = f.add(c[off + i], prod[i]);
+    }
+    poly_trim(f, c);
+    return c;
+}
+
+// g with h * g = 1 mod x^n, by Newton iteration g <- g (2 - h g); h[0] != 0.
+template <class F, class E = typename F::elem>
+vector<E> poly_inv_series(const F &f, const vector<E> &h, size_t n) {
+    vector<E> g{f.inv(h[0])};
+    for (size_t m = 1; m < n;) {
+        m = min(2 * m, n);
+        vector<E> hm(h.begin(), h.begin() + min(m, h.size()));
+        vector<E> e = poly_mul_fast(f, hm, g);
+        e.resize(m, f.zero());
+        for (E &v : e) v = f.neg(v);
+        e[0] = f.add(e[0], f.add(f.one(), f.one()));
+        g = poly_mul_fast(f, g, e);
+        g.resize(m, f.zero());
+    }
+    return g;
+}
+
+// a mod b (b nonzero): the quotient is the reversed product rev(a) / rev(b)
+// truncated to deg a - deg b + 1 terms.
+template <class F, class E = typename F::elem>
+vector<E> poly_rem_fast(const F &f, const vector<E> &a, const vector<E> &b) {
+    if (a.size() < b.size()) return a;
+    size_t qn = a.size() - b.size() + 1;
+    if (b.size() <= kKaratsubaMin || qn <= kKaratsubaMin) {
+        vector<E> q, r;
+        poly_divmod(f, a, b, q, r);
+        return r;
+    }
+    vector<E> ra(a.rbegin(), a.rbegin() + qn), rb(b.rbegin(), b.rend());
+    vector<E> q = poly_mul_fast(f, ra, poly_inv_series(f, rb, qn));
+    q.resize(qn, f.zero());
+    reverse(q.begin(), q.end());
+    vector<E> r = poly_sub(f, a, poly_mul_fast(f, q, b));
+    r.resize(min(r.size(), b.size() - 1));
+    poly_trim(f, r);
+    return r;
+}
+
+// level[0][i] = x - x_i; each level above multiplies neighbours in pairs (an
+// odd last node is carried up as is), so level.back()[0] = prod_i (x - x_i).
+template <class F, class E = typename F::elem>
+struct SubproductTree {
+    vector<vector<vector<E>>> level;
+
+    SubproductTree(const F &f, const vector<E> &xs) {
+        level.emplace_back();
+        for (const E &x : xs) level[0].push_back({f.neg(x), f.one()});
+        while (level.back().size() > 1) {
+            const vector<vector<E>> &below = level.back();
+            vector<vector<E>> up;
+            for (size_t j = 0; j < below.size(); j += 2)
+                up.push_back(j + 1 < below.size() ? poly_mul_fast(f, below[j], below[j + 1]) : below[j]);
+            level.push_back(move(up));
+        }
+    }
+    const vector<E> &root() const { return level.back()[0]; }
+
+    // p(x_i) for every leaf, by the remainder tree. The descent stops at nodes
+    // of kTreeLeafBlock points, whose remainders are evaluated by Horner.
+    vector<E> evaluate(const F &f, const vector<E> &p) const {
+        vector<vector<E>> rem{poly_rem_fast(f, p, root())};
+        size_t stop = 0;
+        while (stop + 1 < level.size() && (size_t(1) << stop) < kTreeLeafBlock) ++stop;
+        for (size_t l = level.size() - 1; l-- > stop;) {
+            vector<vector<E>> down(level[l].size());
+            for (size_t j = 0; j < level[l].size(); ++j)
+                down[j] = j % 2 == 0 && j + 1 == level[l].size() ? rem[j / 2]
+                                                                 : poly_rem_fast(f, rem[j / 2], level[l][j]);
+            rem.swap(down);
+        }
+        vector<E> out(level[0].size());
+        for (size_t i = 0; i < out.size(); ++i) out[i] = poly_eval(f, rem[i >> stop], f.neg(level[0][i][0]));
+        return out;
+    }
+
+    // sum_i c_i * prod_{j!=i} (x - x_j), by the linear-combination tree.
+    vector<E> combine(const F &f, const vector<E> &c) const {
+        vector<vector<E>> acc(c.size());
+        for (size_t i = 0; i < c.size(); ++i) acc[i] = f.is_zero(c[i]) ? vector<E>{} : vector<E>{c[i]};
+        for (size_t l = 0; l + 1 < level.size(); ++l) {
+            vector<vector<E>> up;
+            for (size_t j = 0; j < acc.size(); j += 2) {
+                if (j + 1 == acc.size()) {
+                    up.push_back(move(acc[j]));
+                    continue;
+                }
+                vector<E> s = poly_mul_fast(f, acc[j], level[l][j + 1]), t = poly_mul_fast(f, acc[j + 1], level[l][j]);
+                s.resize(max(s.size(), t.size()), f.zero());
+                for (size_t i = 0; i < t.size(); ++i) s[i] = f.add(s[i], t[i]);
+                poly_trim(f, s);
+                up.push_back(move(s));
+            }
+            acc.swap(up);
+        }
+        return acc[0];
+    }
+};
+
+template <class F, class E = typename F::elem>
+vector<E> poly_derivative(const F &f, const vector<E> &a) {
+    vector<E> d;
+    for (size_t i = 1; i < a.size(); ++i) d.push_back(f.mul(f.from_int((long long)i), a[i]));
+    poly_trim(f, d);
+    return d;
+}
+
+// interpolate_coeffs_modp in O(M(k) log k): c_i = y_i / M'(x_i), then the
+// combination tree sums c_i M(x) / (x - x_i).
+template <class F, class E = typename F::elem>
+bool interpolate_coeffs_tree(const F &f, const vector<E> &xs, const vector<E> &ys, vector<E> &coeffs) {
+    SubproductTree<F, E> tree(f, xs);
+    vector<E> w = tree.evaluate(f, poly_derivative(f, tree.root()));
+    if (!batch_invert(f, w)) return false;
+    for (size_t i = 0; i < w.size(); ++i) w[i] = f.mul(ys[i], w[i]);
+    coeffs = tree.combine(f, w);
+    coeffs.resize(xs.size(), f.zero());
+    return true;
+}
+
+// All k coefficients of the interpolant over a prime field in O(k^2): the
+// Lagrange basis polynomials are M(x) / (x - x_i) with M(x) = prod_j (x - x_j).
+// From kTreeInterpolationMin points on the subproduct tree takes over.
+template <class F>
+bool interpolate_coeffs_modp(const F &f, const vector<typename F::elem> &xs, const vector<typename F::elem> &ys,
+                             vector<typename F::elem> &coeffs) {
+    using E = typename F::elem;
+    int k = xs.size();
+    if (k >= kTreeInterpolationMin) return interpolate_coeffs_tree(f, xs, ys, coeffs);
+    vector<E> M(k + 1, f.zero());
+    M[0] = f.one();
+    for (int j = 0; j < k; ++j) {
+        for (int t = j + 1; t > 0; --t) M[t] = f.sub(M[t - 1], f.mul(M[t], xs[j]));
+        M[0] = f.neg(f.mul(M[0], xs[j]));
+    }
+    vector<E> w(k, f.one());
+    for (int i = 0; i < k; ++i)
+        for (int j = 0; j < k; ++j)
+            if (j != i) w[i] = f.mul(w[i], f.sub(xs[i], xs[j]));
+    if (!batch_invert(f, w)) return false;
+    coeffs.assign(k, f.zero());
+    for (int i = 0; i < k; ++i) {
+        E c = f.mul(ys[i], w[i]);
+        E q = M[k];
+        for (int t = k - 1; t >= 0; --t) {
+            coeffs[t] = f.add(coeffs[t], f.mul(c, q));
+            if (t) q = f.add(M[t], f.mul(q, xs[i]));
+        }
+    }
+    return true;
+}
+
+// ---------- decode arbitrary-base string to cpp_int ----------
+// Digits are validated first (whitespace skipped, the first bad character
+// throws), then converted without any per-digit bignum work: power-of-two bases
+// are bit-packed straight into limbs, other bases are packed into 64-bit chunks
+// of as many digits as fit and the chunks are merged pairwise, bottom up, with
+// cached powers base^(m * 2^j). Each level of that tree multiplies numbers of
+// equal size, so the cost follows the big-int multiply rather than O(L^2).
+inline void collect_digits(string_view s_raw, int base, vector<uint8_t> &digits) {
+    digits.clear();
+    digits.reserve(s_raw.size());
+    for (char ch : s_raw) {
+        if (isspace((unsigned char)ch)) continue;
+        int d = -1;
+        if (ch >= '0' && ch <= '9') d = ch - '0';
+        else if (ch >= 'a' && ch <= 'z') d = ch - 'a' + 10;
+        else if (ch >= 'A' && ch <= 'Z') d = ch - 'A' + 10;
+        else throw runtime_error(string("invalid digit: ") + ch);
+        if (d < 0 || d >= base) throw runtime_error("digit >= base in parse_in_base_cpp");
+        digits.push_back((uint8_t)d);
+    }
+}
+
+// m digits per 64-bit chunk, with power = base^m the largest such power below 2^64
+struct ChunkInfo {
+    int digits;
+    uint64_t power;
+};
+
+constexpr ChunkInfo chunk_info(uint64_t base) {
+    ChunkInfo c{0, 1};
+    while (c.power <= UINT64_MAX / base) { c.power *= base; ++c.digits; }
+    return c;
+}
+
+// base^(m * 2^level), cached per thread
+inline const cpp_int &chunk_power(int base, size_t level) {
+    thread_local unordered_map<int, vector<cpp_int>> cache;
+    vector<cpp_int> &powers = cache[base];
+    if (powers.empty()) powers.push_back(cpp_int(chunk_info((uint64_t)base).power));
+    while (powers.size() <= level) powers.push_back(powers.back() * powers.back());
+    return powers[level];
+}
+
+inline cpp_int pack_bits(const vector<uint8_t> &digits, int bits) {
+    vector<uint64_t> limbs((digits.size() * bits + 63) / 64 + 1, 0);
+    size_t bit = 0;
+    for (size_t i = digits.size(); i-- > 0; bit += bits) {
+        unsigned __int128 d = (unsigned __int128)digits[i] << (bit % 64);
+        limbs[bit / 64] |= (uint64_t)d;
+        if (bit % 64 + bits > 64) limbs[bit / 64 + 1] |= (uint64_t)(d >> 64);
+    }
+    cpp_int val;
+    import_bits(val, limbs.data(), limbs.data() + limbs.size(), 64, false);
+    return val;
+}
+
+inline cpp_int combine_chunks(const vector<uint8_t> &digits, int base, ChunkInfo info) {
+    size_t L = digits.size();
+    if (L == 0) return 0;
+    vector<cpp_int> level;
+    level.reserve(L / info.digits + 1);
+    for (size_t end = L; end > 0;) { // least significant chunk first
+        size_t begin = end > (size_t)info.digits ? end - info.digits : 0;
+        uint64_t chunk = 0;
+        for (size_t i = begin; i < end; ++i) chunk = chunk * (uint64_t)base + digits[i];
+        level.push_back(chunk);
+        end = begin;
+    }
+    for (size_t j = 0; level.size() > 1; ++j) {
+        const cpp_int &P = chunk_power(base, j);
+        size_t half = (level.size() + 1) / 2;
+        for (size_t i = 0; i < half; ++i) {
+            if (2 * i + 1 < level.size()) level[i] = level[2 * i] + level[2 * i + 1] * P;
+            else level[i] = move(level[2 * i]);
+        }
+        level.resize(half);
+    }
+    return move(level[0]);
+}
+
+template <int Base>
+inline cpp_int parse_in_base_fixed(const vector<uint8_t> &digits) {
+    if constexpr ((Base & (Base - 1)) == 0) {
+        constexpr int bits = Base == 2 ? 1 : Base == 4 ? 2 : Base == 8 ? 3 : Base == 16 ? 4 : 5;
+        return pack_bits(digits, bits);
+    } else {
+        constexpr ChunkInfo info = chunk_info(Base);
+        return combine_chunks(digits, Base, info);
+    }
+}
+
+inline cpp_int parse_in_base_cpp(string_view s_raw, int base) {
+    thread_local vector<uint8_t> digits;
+    collect_digits(s_raw, base, digits);
+    if (base >= 2 && digits.size() <= 128) { // most shares fit in 128 bits: no limb loop
+        unsigned __int128 acc = 0;
+        bool fits = true;
+        for (uint8_t d : digits)
+            if (__builtin_mul_overflow(acc, (unsigned)base, &acc) || __builtin_add_overflow(acc, d, &acc)) {
+                fits = false;
+                break;
+            }
+        if (fits) {
+            cpp_int v = (uint64_t)(acc >> 64);
+            v <<= 64;
+            v |= (uint64_t)acc;
+            return v;
+        }
+    }
+    switch (base) {
+    case 2: return parse_in_base_fixed<2>(digits);
+    case 8: return parse_in_base_fixed<8>(digits);
+    case 10: return parse_in_base_fixed<10>(digits);
+    case 16: return parse_in_base_fixed<16>(digits);
+    default: break;
+    }
+    if (base < 2) return 0; // only zero digits get past validation
+    if ((base & (base - 1)) == 0) {
+        int bits = 0;
+        while ((1 << bits) < base) ++bits;
+        return pack_bits(digits, bits);
+    }
+    return combine_chunks(digits, base, chunk_info((uint64_t)base));
+}
+
+
+// ---------- Solve Vandermonde via Gaussian elimination ----------
+// The matrix lives in the thread's limb arena and is released in one step when
+// the call returns; only the final coefficients are copied out to the heap.
+inline bool interpolate_gauss(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff) {
+    ArenaScope scope;
+    int k = xs.size();
+    FlatMatrix<LazyFrac> A(k, k + 1);
+    for (int i = 0; i < k; ++i) {
+        LazyFrac *a = A.row(i);
+        arena_int power = 1;
+        for (int j = 0; j < k; ++j) {
+            a[j].num = power;
+            power *= xs[i];
+        }
+        a[k].num = arena_int(ys[i]);
+    }
+
+    LazyFrac pivot, factor;
+    for (int col = 0, row = 0; col < k && row < k; ++col, ++row) {
+        int sel = row;
+        for (int r = row; r < k; ++r) {
+            if (!A.at(r, col).is_zero()) { sel = r; break; }
+        }
+        if (A.at(sel, col).is_zero()) return false;
+        if (sel != row) A.swap_rows(sel, row);
+
+        LazyFrac *pr = A.row(row);
+        pivot = pr[col];
+        for (int c = col; c <= k; ++c) pr[c].div(pivot);
+
+        for (int r = 0; r < k; ++r) {
+            if (r == row) continue;
+            LazyFrac *ar = A.row(r);
+            if (ar[col].is_zero()) continue;
+            factor = ar[col];
+            for (int c = col; c <= k; ++c) ar[c].sub_mul(factor, pr[c]);
+        }
+    }
+
+    // 🔴 FIX: allow negative or zero coefficients
+    for (int i = 0; i < k; ++i) {
+        if (!A.at(i, k).is_integer()) return false;
+    }
+    out_coeff.assign(k, Frac(0, 1));
+    for (int i = 0; i < k; ++i) {
+        LazyFrac &v = A.at(i, k);
+        v.normalize();
+        out_coeff[i] = Frac(cpp_int(v.num), cpp_int(v.den));
+    }
+    return true;
+}
+
+// ---------- Fraction-free (Bareiss) Gauss-Jordan elimination ----------
+// Every update A[r][c] = (p * A[r][c] - A[r][col] * A[row][c]) / prev divides
+// exactly, so entries stay integers bounded by minors of [V | y] and no gcd is
+// ever taken. At the end every diagonal entry equals det(V) and the last column
+// holds the Cramer numerators, so a coefficient is integral iff its numerator
+// is divisible by the determinant.
+inline bool interpolate_bareiss(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff) {
+    ArenaScope scope;
+    int k = xs.size();
+    FlatMatrix<arena_int> A(k, k + 1);
+    for (int i = 0; i < k; ++i) {
+        arena_int *a = A.row(i);
+        arena_int power = 1;
+        for (int j = 0; j < k; ++j) {
+            a[j] = power;
+            power *= xs[i];
+        }
+        a[k] = arena_int(ys[i]);
+    }
+
+    arena_int prev = 1, t, f;
+    for (int row = 0; row < k; ++row) {
+        int sel = row;
+        while (sel < k && A.at(sel, row) == 0) ++sel;
+        if (sel == k) return false;
+        if (sel != row) A.swap_rows(sel, row);
+
+        arena_int *pr = A.row(row);
+        const arena_int &p = pr[row];
+        for (int r = 0; r < k; ++r) {
+            if (r == row) continue;
+            arena_int *ar = A.row(r);
+            f = ar[row];
+            for (int c = row + 1; c <= k; ++c) {
+                t = f * pr[c];
+                ar[c] *= p;
+                ar[c] -= t;
+                ar[c] /= prev;
+            }
+            if (r < row) ar[r] = p; // was prev, so (p * prev - 0) / prev
+            ar[row] = 0;
+        }
+        stat_bits(p);
+        prev = p;
+    }
+
+    const arena_int &det = A.at(k - 1, k - 1);
+    for (int i = 0; i < k; ++i) {
+        if (A.at(i, k) % det != 0) return false;
+    }
+    out_coeff.assign(k, Frac(0, 1));
+    for (int i = 0; i < k; ++i) out_coeff[i] = Frac(cpp_int(A.at(i, k) / det), 1);
+    return true;
+}
+
+// ---------- Lagrange weight cache ----------
+// Everything in the Lagrange solve that depends only on the sorted x-set:
+// w_i = prod_{j!=i} (x_i - x_j), D = lcm(|w_i|), scale_i = D / w_i, the
+// numerators of the basis values at zero, at0_i = scale_i * prod_{j!=i} (-x_j),
+// so D * f(0) = sum y_i * at0_i. The screen_* fields hold the same relation
+// reduced modulo g = gcd(D, M) for each screening modulus M (see
+// IntegralityScreen).
+constexpr uint64_t kScreenModuli[2] = {
+    (1ull << 24) * 14348907ull * 625 * 49,                   // 2^24 3^15 5^4 7^2
+    11ull * 13 * 17 * 19 * 23 * 29 * 31 * 37 * 41 * 43 * 47 * 53, // primes 11..53
+};
+
+struct LagrangeBasis {
+    vector<int> xs; // sorted, distinct
+    cpp_int D;
+    vector<cpp_int> scale, at0;
+    uint64_t screen_g[2] = {1, 1};
+    vector<uint64_t> screen_at0[2];
+};
+
+inline uint64_t mod_word(const cpp_int &v, uint64_t m) {
+    cpp_int r = v % m;
+    if (r < 0) r += m;
+    return (uint64_t)r;
+}
+
+inline void fill_screen(LagrangeBasis &b) {
+    for (int m = 0; m < 2; ++m) {
+        uint64_t g = std::gcd(mod_word(b.D, kScreenModuli[m]), kScreenModuli[m]);
+        b.screen_g[m] = g;
+        b.screen_at0[m].clear();
+        if (g == 1) continue;
+        for (const cpp_int &v : b.at0) b.screen_at0[m].push_back(mod_word(v, g));
+    }
+}
+
+// Returns null when the x-set has a repeated value.
+inline shared_ptr<const LagrangeBasis> build_lagrange_basis(const vector<int> &sorted_xs) {
+    int k = sorted_xs.size();
+    auto b = make_shared<LagrangeBasis>();
+    b->xs = sorted_xs;
+    vector<cpp_int> w(k, 1);
+    for (int i = 0; i < k; ++i) {
+        for (int j = 0; j < k; ++j) {
+            if (j == i) continue;
+            long long d = (long long)sorted_xs[i] - sorted_xs[j];
+            if (d == 0) return nullptr;
+            w[i] *= d;
+        }
+    }
+    b->D = 1;
+    for (int i = 0; i < k; ++i) {
+        cpp_int a = abs(w[i]);
+        b->D = b->D / boost::multiprecision::gcd(b->D, a) * a;
+    }
+    b->scale.resize(k);
+    for (int i = 0; i < k; ++i) b->scale[i] = b->D / w[i];
+
+    // q_i(0) = prod_{j!=i} (-x_j), via prefix/suffix products.
+    vector<cpp_int> suffix(k + 1, 1);
+    for (int j = k - 1; j >= 0; --j) suffix[j] = suffix[j + 1] * (-(long long)sorted_xs[j]);
+    b->at0.resize(k);
+    cpp_int prefix = 1;
+    for (int i = 0; i < k; ++i) {
+        b->at0[i] = b->scale[i] * prefix * suffix[i + 1];
+        prefix *= -(long long)sorted_xs[i];
+    }
+    fill_screen(*b);
+    return b;
+}
+
+// Checks one basis from outside (a cache file) against its x-set: the first
+// and last weights are recomputed, scale_i * w_i must be D and at0_i must be
+// scale_i * prod_{j!=i} (-x_j).
+inline bool basis_consistent(const LagrangeBasis &b) {
+    int k = b.xs.size();
+    for (int i : {0, k - 1}) {
+        cpp_int w = 1, q = 1;
+        for (int j = 0; j < k; ++j) {
+            if (j == i) continue;
+            long long d = (long long)b.xs[i] - b.xs[j];
+            if (d == 0) return false;
+            w *= d;
+            q *= -(long long)b.xs[j];
+        }
+        if (b.scale[i] * w != b.D || b.scale[i] * q != b.at0[i]) return false;
+    }
+    return true;
+}
+
+// FNV-1a, the per-line checksum of the cache files.
+inline uint64_t line_hash(string_view s) {
+    uint64_t h = 1469598103934665603ull;
+    for (char c : s) h = (h ^ (unsigned char)c) * 1099511628211ull;
+    return h;
+}
+
+// Splits "body sum" into the body when sum is its line_hash in hex.
+inline bool checked_line(const string &line, string_view &body) {
+    size_t cut = line.rfind(' ');
+    if (cut == string::npos) return false;
+    char *end = nullptr;
+    unsigned long long sum = strtoull(line.c_str() + cut + 1, &end, 16);
+    body = string_view(line.data(), cut);
+    return end == line.c_str() + line.size() && end != line.c_str() + cut + 1 && sum == line_hash(body);
+}
+
+// Bounded LRU of LagrangeBasis keyed by the sorted x-set, shared by all threads.
+// Bounded by entry count (--weight-cache) and by kMaxBytes of limbs; a lex
+// search revisits the same sets per object, so the default holds all C(16, 8)
+// of a mid-sized search. Searches over many more x-sets than that would only
+// churn the LRU under its lock, so ShamirSolver turns the cache off for them
+// (worth_caching). Misses are built outside the lock. Capacity 0 disables
+// caching. The cache can be saved to and reloaded from a text file so repeated
+// runs start warm.
+class LagrangeWeightCache {
+public:
+    static LagrangeWeightCache &global() {
+        static LagrangeWeightCache cache;
+        return cache;
+    }
+
+    void set_capacity(size_t cap) {
+        lock_guard<mutex> lock(mu_);
+        cap_ = cap;
+        evict();
+    }
+
+    // Whether a search over about `sets` x-sets should use the cache.
+    bool worth_caching(uint64_t sets) const {
+        lock_guard<mutex> lock(mu_);
+        return cap_ > 0 && sets / kReuseSpan <= cap_;
+    }
+
+    // use = false builds the basis without touching the cache.
+    shared_ptr<const LagrangeBasis> get(const vector<int> &sorted_xs, bool use = true) {
+        if (!use) return build_lagrange_basis(sorted_xs);
+        {
+            lock_guard<mutex> lock(mu_);
+            if (cap_ == 0) return build_lagrange_basis(sorted_xs);
+            auto it = index_.find(sorted_xs);
+            if (it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return *it->second;
+            }
+        }
+        shared_ptr<const LagrangeBasis> b = build_lagrange_basis(sorted_xs);
+        if (b) insert(b);
+        return b;
+    }
+
+    // Format: one entry per line, "k x_1..x_k D scale_1..k at0_1..k sum",
+    // most recently used first, where sum is the hex FNV-1a hash of the line
+    // before it. A missing file is not an error; a corrupted entry or one whose
+    // weights do not belong to its x-set (basis_consistent) rejects the file.
+    bool load(const string &path) {
+        ifstream in(path);
+        if (!in) return true;
+        string line;
+        vector<shared_ptr<const LagrangeBasis>> entries;
+        while (getline(in, line)) {
+            if (line.empty()) continue;
+            string_view body;
+            if (!checked_line(line, body)) return false;
+            istringstream ls{string(body)};
+            size_t k;
+            if (!(ls >> k) || k == 0 || k > 4096) return false;
+            auto b = make_shared<LagrangeBasis>();
+            b->xs.resize(k);
+            b->scale.resize(k);
+            b->at0.resize(k);
+            for (int &x : b->xs) ls >> x;
+            ls >> b->D;
+            for (cpp_int &v : b->scale) ls >> v;
+            for (cpp_int &v : b->at0) ls >> v;
+            if (!ls || !(ls >> ws).eof() || !is_sorted(b->xs.begin(), b->xs.end()) || b->D <= 0) return false;
+            if (!basis_consistent(*b)) return false;
+            fill_screen(*b);
+            entries.push_back(std::move(b));
+        }
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) insert(*it);
+        return true;
+    }
+
+    bool save(const string &path) const {
+        ofstream out(path, ios::trunc);
+        if (!out) return false;
+        lock_guard<mutex> lock(mu_);
+        for (const auto &b : lru_) {
+            ostringstream line;
+            line << b->xs.size();
+            for (int x : b->xs) line << ' ' << x;
+            line << ' ' << b->D;
+            for (const cpp_int &v : b->scale) line << ' ' << v;
+            for (const cpp_int &v : b->at0) line << ' ' << v;
+            string body = line.str();
+            out << body << ' ' << hex << line_hash(body) << dec << '\n';
+        }
+        return bool(out);
+    }
+
+private:
+    struct KeyHash {
+        size_t operator()(const vector<int> &v) const {
+            uint64_t h = 1469598103934665603ull;
+            for (int x : v) h = (h ^ (uint32_t)x) * 1099511628211ull;
+            return h;
+        }
+    };
+    using List = list<shared_ptr<const LagrangeBasis>>;
+
+    static size_t footprint(const LagrangeBasis &b) {
+        size_t bytes = sizeof(LagrangeBasis) + b.xs.size() * sizeof(int) + msb(b.D) / 8;
+        for (const cpp_int &v : b.scale) bytes += sizeof(cpp_int) + (v == 0 ? 0 : msb(abs(v)) / 8);
+        for (const cpp_int &v : b.at0) bytes += sizeof(cpp_int) + (v == 0 ? 0 : msb(abs(v)) / 8);
+        return bytes;
+    }
+    void insert(const shared_ptr<const LagrangeBasis> &b) {
+        size_t bytes = footprint(*b);
+        lock_guard<mutex> lock(mu_);
+        if (cap_ == 0 || index_.count(b->xs)) return;
+        lru_.push_front(b);
+        index_.emplace(b->xs, lru_.begin());
+        bytes_ += bytes;
+        evict();
+    }
+    void evict() {
+        while (!lru_.empty() && (lru_.size() > cap_ || bytes_ > kMaxBytes)) {
+            bytes_ -= footprint(*lru_.back());
+            index_.erase(lru_.back()->xs);
+            lru_.pop_back();
+        }
+    }
+
+    static constexpr size_t kMaxBytes = size_t(64) << 20;
+    static constexpr uint64_t kReuseSpan = 4; // cache searches over at most kReuseSpan * capacity x-sets
+
+    mutable mutex mu_;
+    size_t cap_ = 16384, bytes_ = 0;
+    List lru_;
+    unordered_map<vector<int>, List::iterator, KeyHash> index_;
+};
+
+// ---------- Integrality screen ----------
+// D * f(0) = sum y_i * at0_i, and f(0) is an integer only if D divides that sum,
+// so it must vanish modulo every divisor of D. The divisors used are
+// g = gcd(D, M) for two fixed word-sized M built from the small primes that
+// the Vandermonde weights are made of. With y_i mod M reduced once per
+// object, rejecting a subset costs k word multiplies and no big integers.
+// Passing proves nothing; survivors still go through the exact engine.
+// (Random large primes would not work here: every denominator is a unit
+// modulo them.)
+class IntegralityScreen {
+public:
+    IntegralityScreen() = default;
+    IntegralityScreen(const vector<int> &xs_full, const vector<cpp_int> &ys_full, bool cache_weights = true) {
+        reset(xs_full, ys_full, cache_weights);
+    }
+
+    // Rebinds the screen to another share set, keeping its buffers.
+    void reset(const vector<int> &xs_full, const vector<cpp_int> &ys_full, bool cache_weights = true) {
+        xs_ = &xs_full;
+        cache_weights_ = cache_weights;
+        for (int m = 0; m < 2; ++m) {
+            res_[m].clear();
+            for (const cpp_int &y : ys_full) res_[m].push_back(mod_word(y, kScreenModuli[m]));
+        }
+    }
+
+    // idx: share indices of one subset. False means f(0) is certainly not integral.
+    bool may_pass(const vector<int> &idx) {
+        const vector<int> &xs = *xs_;
+        size_t k = idx.size();
+        order_.assign(idx.begin(), idx.end());
+        auto by_x = [&](int a, int b) { return xs[a] < xs[b]; };
+        if (!is_sorted(order_.begin(), order_.end(), by_x)) sort(order_.begin(), order_.end(), by_x);
+        key_.resize(k);
+        for (size_t i = 0; i < k; ++i) key_[i] = xs[order_[i]];
+        shared_ptr<const LagrangeBasis> b = LagrangeWeightCache::global().get(key_, cache_weights_);
+        if (!b) return true; // repeated x: let the engine decide
+        for (int m = 0; m < 2; ++m) {
+            uint64_t g = b->screen_g[m];
+            if (g == 1) continue;
+            uint64_t acc = 0;
+            for (size_t i = 0; i < k; ++i) {
+                acc += mulmod_u64(res_[m][order_[i]] % g, b->screen_at0[m][i], g);
+                if (acc >= g) acc -= g;
+            }
+            if (acc != 0) return false;
+        }
+        return true;
+    }
+
+private:
+    const vector<int> *xs_ = nullptr;
+    bool cache_weights_ = true;
+    vector<uint64_t> res_[2];
+    vector<int> order_, key_;
+};
+
+// ---------- Batched p-adic screen ----------
+// f(0) = sum y_i lambda_i with lambda_i = prod_{j!=i} x_j / (x_j - x_i). For a
+// prime q split every factor into q^v * (unit) once per object: V[i][j] =
+// v_q(x_j) - v_q(x_j - x_i) and T[i][j] = unit(x_j) / unit(x_j - x_i) mod q^e.
+// A subset's weights are then lambda_i = q^E_i * U_i, with E_i and U_i sums and
+// products of table entries, and f(0) is q-integral iff
+// sum y_i U_i q^(E_i - min E) vanishes modulo q^(-min E) (checked up to q^e).
+// q = 2 works modulo 2^64 in wrapping arithmetic; 3, 5 and 7 use 32-bit
+// Montgomery products in 64-bit lanes. There is no per-subset modulus and no
+// cache lookup, so kLanes subsets run side by side in GCC vector lanes.
+// Objects with x = 0, repeated x or more than kMaxShares shares skip it. The
+// k^2 gathers per subset only beat the cached per-subset screen once k is
+// large, so it is also skipped below kMinK.
+class AdicBatchScreen {
+public:
+    static constexpr int kLanes = 8;
+    typedef uint64_t lanes_u __attribute__((vector_size(8 * kLanes)));
+    typedef int64_t lanes_i __attribute__((vector_size(8 * kLanes)));
+
+    AdicBatchScreen() = default;
+    AdicBatchScreen(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k) { reset(xs_full, ys_full, k); }
+
+    // Rebuilds the tables for another share set, keeping their buffers.
+    void reset(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k) {
+        n_ = xs_full.size();
+        enabled_ = false;
+        if (n_ > kMaxShares || k > kMaxK || k < kMinK) return;
+        for (int x : xs_full) if (x == 0) return;
+        for (int q = 0; q < kOdd; ++q) {
+            Odd &o = odd_[q];
+            o.m = 1;
+            o.e = 0;
+            while (o.m * kOddPrimes[q] < (1ull << 31)) { o.m *= kOddPrimes[q]; ++o.e; }
+            uint64_t inv = 1; // -m^-1 mod 2^32
+            for (int i = 0; i < 5; ++i) inv *= 2 - o.m * inv;
+            o.pinv = (0 - inv) & 0xffffffffu;
+            o.r = (1ull << 32) % o.m;
+            uint64_t pw = 1;
+            for (int s = 0; s <= o.e; ++s, pw *= kOddPrimes[q]) o.pow_r[s] = s < o.e ? mul_mod(pw, o.r, o.m) : 0;
+            o.y.clear();
+            for (const cpp_int &y : ys_full) {
+                cpp_int r = y % o.m;
+                o.y.push_back((uint64_t)(r < 0 ? r + o.m : r));
+            }
+        }
+        cells_.assign((size_t)n_ * n_, Cell{});
+        for (int i = 0; i < n_; ++i)
+            for (int j = 0; j < n_; ++j) {
+                if (i == j) continue;
+                long long xj = xs_full[j], d = xj - xs_full[i];
+                if (d == 0) return;
+                Cell &c = cells_[(size_t)i * n_ + j];
+                int vx = __builtin_ctzll((uint64_t)xj), vd = __builtin_ctzll((uint64_t)d);
+                c.t2 = (uint64_t)(xj >> vx) * inv_odd((uint64_t)(d >> vd));
+                c.v[0] = (int16_t)(vx - vd);
+                for (int q = 0; q < kOdd; ++q) {
+                    const Odd &o = odd_[q];
+                    long long p = kOddPrimes[q], ux = xj, ud = d;
+                    int wx = 0, wd = 0;
+                    while (ux % p == 0) { ux /= p; ++wx; }
+                    while (ud % p == 0) { ud /= p; ++wd; }
+                    uint64_t t = mul_mod(residue(ux, o.m), inv_mod(residue(ud, o.m), o.m), o.m);
+                    c.t[q] = (uint32_t)mul_mod(t, o.r, o.m); // Montgomery form
+                    c.v[q + 1] = (int16_t)(wx - wd);
+                }
+            }
+        y2_.clear();
+        for (const cpp_int &y : ys_full) {
+            uint64_t lo = (uint64_t)(abs(y) & cpp_int(UINT64_MAX));
+            y2_.push_back(y < 0 ? 0 - lo : lo);
+        }
+        enabled_ = true;
+    }
+
+    bool enabled() const { return enabled_; }
+
+    // subsets: count (<= kLanes) rows of k share indices. Bit l of the result
+    // is set when subset l may have an integral f(0).
+    unsigned screen(const int *subsets, int count, int k) const {
+        unsigned all = (1u << count) - 1;
+        size_t sub[kLanes * kMaxK];
+        for (int l = 0; l < kLanes; ++l) // idle lanes repeat lane 0
+            for (int a = 0; a < k; ++a) sub[l * kMaxK + a] = subsets[(l < count ? l : 0) * k + a];
+
+        lanes_u U[kPrimes][kMaxK];
+        lanes_i E[kPrimes][kMaxK], emin[kPrimes];
+        for (int a = 0; a < k; ++a) {
+            // Lanes are gathered into scalar rows and copied in whole, which
+            // keeps GCC from seeing partly written vectors.
+            uint64_t ur[kPrimes][kLanes];
+            for (int l = 0; l < kLanes; ++l) {
+                size_t si = sub[l * kMaxK + a];
+                ur[0][l] = y2_[si];
+                for (int q = 0; q < kOdd; ++q) ur[q + 1][l] = odd_[q].y[si];
+            }
+            lanes_u u[kPrimes];
+            lanes_i e[kPrimes] = {};
+            memcpy(u, ur, sizeof u);
+            for (int b = 0; b < k; ++b) {
+                if (b == a) continue;
+                uint64_t tr[kPrimes][kLanes];
+                int64_t vr[kPrimes][kLanes];
+                for (int l = 0; l < kLanes; ++l) {
+                    const Cell &c = cells_[sub[l * kMaxK + a] * n_ + sub[l * kMaxK + b]];
+                    tr[0][l] = c.t2;
+                    for (int q = 0; q < kOdd; ++q) tr[q + 1][l] = c.t[q];
+                    for (int q = 0; q < kPrimes; ++q) vr[q][l] = c.v[q];
+                }
+                lanes_u t[kPrimes];
+                lanes_i v[kPrimes];
+                memcpy(t, tr, sizeof t);
+                memcpy(v, vr, sizeof v);
+                u[0] *= t[0];
+                for (int q = 0; q < kOdd; ++q) mont(u[q + 1], t[q + 1], odd_[q]);
+                for (int q = 0; q < kPrimes; ++q) e[q] += v[q];
+            }
+            for (int q = 0; q < kPrimes; ++q) {
+                U[q][a] = u[q];
+                E[q][a] = e[q];
+                emin[q] = a == 0 ? e[q] : (e[q] < emin[q] ? e[q] : emin[q]);
+            }
+        }
+
+        unsigned alive = all;
+        { // q = 2, modulo 2^64
+            lanes_u acc = {};
+            for (int a = 0; a < k; ++a) {
+                lanes_i shift = E[0][a] - emin[0];
+                acc += (U[0][a] << (lanes_u)(shift & 63)) & (lanes_u)(shift < 64);
+            }
+            for (int l = 0; l < count; ++l) {
+                int64_t need = -emin[0][l];
+                uint64_t low = need <= 0 ? 0 : need >= 64 ? acc[l] : acc[l] & ((1ull << need) - 1);
+                if (low != 0) alive &= ~(1u << l);
+            }
+        }
+        for (int q = 0; q < kOdd; ++q) {
+            const Odd &o = odd_[q];
+            lanes_u acc = {};
+            for (int a = 0; a < k; ++a) {
+                lanes_i shift = E[q + 1][a] - emin[q + 1];
+                uint64_t pr[kLanes];
+                for (int l = 0; l < kLanes; ++l) pr[l] = o.pow_r[shift[l] < o.e ? shift[l] : o.e];
+                lanes_u pw;
+                memcpy(&pw, pr, sizeof pw);
+                mont(pw, U[q + 1][a], o);
+                acc += pw;
+                acc -= (lanes_u)(acc >= o.m) & o.m;
+            }
+            for (int l = 0; l < count; ++l) {
+                int64_t need = min<int64_t>(-emin[q + 1][l], o.e);
+                if (need <= 0) continue;
+                uint64_t qn = 1;
+                for (int s = 0; s < need; ++s) qn *= kOddPrimes[q];
+                if (acc[l] % qn != 0) alive &= ~(1u << l);
+            }
+        }
+        return alive;
+    }
+
+private:
+    static constexpr int kMaxShares = 512, kMinK = 11, kMaxK = 64, kOdd = 3, kPrimes = kOdd + 1;
+    static constexpr uint64_t kOddPrimes[kOdd] = {3, 5, 7};
+    struct Odd {
+        uint64_t m, pinv, r; // modulus q^e < 2^31, -m^-1 mod 2^32, 2^32 mod m
+        int e;
+        uint64_t pow_r[32]; // q^s in Montgomery form, 0 for s >= e
+        vector<uint64_t> y;
+    };
+    struct Cell {
+        uint64_t t2;
+        uint32_t t[kOdd];
+        int16_t v[kPrimes];
+    };
+
+    static uint64_t inv_odd(uint64_t u) {
+        uint64_t inv = u;
+        for (int i = 0; i < 5; ++i) inv *= 2 - u * inv;
+        return inv;
+    }
+    static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) { return a * b % m; } // a, b < 2^32
+    static uint64_t residue(long long v, uint64_t m) {
+        long long r = v % (long long)m;
+        return (uint64_t)(r < 0 ? r + (long long)m : r);
+    }
+    static uint64_t inv_mod(uint64_t a, uint64_t m) { // a coprime to m
+        long long t = 0, nt = 1, r = (long long)m, nr = (long long)a;
+        while (nr != 0) {
+            long long qt = r / nr;
+            t -= qt * nt; swap(t, nt);
+            r -= qt * nr; swap(r, nr);
+        }
+        return (uint64_t)(t < 0 ? t + (long long)m : t);
+    }
+    // a <- a * b / 2^32 mod m for a, b < m < 2^31 (by reference: no vector ABI)
+    static void mont(lanes_u &a, const lanes_u &b, const Odd &o) {
+        lanes_u t = a * b;
+        lanes_u mm = ((t & 0xffffffffu) * o.pinv) & 0xffffffffu;
+        a = (t + mm * o.m) >> 32;
+        a -= (lanes_u)(a >= o.m) & o.m;
+    }
+
+    int n_ = 0;
+    bool enabled_ = false;
+    Odd odd_[kOdd];
+    vector<Cell> cells_;
+    vector<uint64_t> y2_;
+};
+
+// ---------- Lagrange interpolation with one combined denominator ----------
+// P(x) = sum_i y_i * prod_{j!=i} (x - x_j) / w_i, with w_i = prod_{j!=i} (x_i - x_j).
+// Everything is scaled by D = lcm(|w_i|), so all arithmetic stays in integers and
+// a coefficient is integral iff its numerator is divisible by D. With the basis
+// for the x-set cached, f(0) is a dot product of ys with at0. The full O(k^2)
+// coefficient vector is built only when f(0) passes, since most rejected subsets
+// already fail there.
+inline bool interpolate_lagrange(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff,
+                                 bool cache_weights = true) {
+    int k = xs.size();
+    vector<int> order(k);
+    iota(order.begin(), order.end(), 0);
+    if (!is_sorted(xs.begin(), xs.end()))
+        sort(order.begin(), order.end(), [&](int a, int b) { return xs[a] < xs[b]; });
+    vector<int> key(k);
+    for (int i = 0; i < k; ++i) key[i] = xs[order[i]];
+    shared_ptr<const LagrangeBasis> basis = LagrangeWeightCache::global().get(key, cache_weights);
+    if (!basis) return false;
+    const LagrangeBasis &B = *basis;
+
+    cpp_int num0 = 0;
+    for (int i = 0; i < k; ++i) num0 += ys[order[i]] * B.at0[i];
+    stat_bits(num0);
+    if (num0 % B.D != 0) return false;
+
+    // Full vector: M(x) = prod_j (x - x_j), then q_i = M / (x - x_i) by synthetic division.
+    vector<cpp_int> M(k + 1, 0);
+    M[0] = 1;
+    for (int j = 0; j < k; ++j) {
+        for (int t = j + 1; t > 0; --t) M[t] = M[t - 1] - M[t] * key[j];
+        M[0] *= -(long long)key[j];
+    }
+    vector<cpp_int> num(k, 0);
+    num[0] = num0;
+    cpp_int sy;
+    for (int i = 0; i < k; ++i) {
+        sy = ys[order[i]] * B.scale[i];
+        cpp_int q = M[k];
+        for (int t = k - 1; t >= 1; --t) {
+            num[t] += sy * q;
+            q = M[t] + q * key[i];
+        }
+    }
+
+    out_coeff.assign(k, Frac(0, 1));
+    for (int t = 0; t < k; ++t) {
+        stat_bits(num[t]);
+        if (num[t] % B.D != 0) return false;
+        out_coeff[t] = Frac(num[t] / B.D, 1);
+    }
+    return true;
+}
+
+// ---------- Multi-modular (CRT) interpolation ----------
+// Interpolates modulo word primes and lifts every coefficient into the symmetric
+// range with Garner's incremental CRT. When one more prime leaves all lifted
+// coefficients unchanged, the candidate is certified exactly by evaluating it at
+// the k points. Integral coefficients are bounded by k * max|y| * prod(1 + |x_j|),
+// so if no candidate certifies once the modulus is well past twice that bound,
+// some coefficient is not an integer.
+inline bool interpolate_crt(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff) {
+    int k = xs.size();
+    {
+        vector<int> sorted_xs(xs);
+        sort(sorted_xs.begin(), sorted_xs.end());
+        if (adjacent_find(sorted_xs.begin(), sorted_xs.end()) != sorted_xs.end()) return false;
+    }
+    size_t bound_bits = (size_t)msb(cpp_int(k)) + 1;
+    size_t ybits = 0;
+    for (const cpp_int &y : ys) if (y != 0) ybits = max(ybits, (size_t)msb(abs(y)) + 1);
+    bound_bits += ybits;
+    for (int x : xs) bound_bits += (size_t)msb(cpp_int(1 + abs((long long)x))) + 1;
+    bound_bits += 64; // integral coefficients must stabilise before this point
+
+    vector<cpp_int> lift(k, 0), centered(k);
+    cpp_int modulus = 1;
+    vector<WordField::elem> xr(k), yr(k), c;
+    for (size_t pi = 0;; ++pi) {
+        const WordField &f = word_prime(pi);
+        uint64_t p = f.p[0];
+        for (int i = 0; i < k; ++i) {
+            xr[i] = f.from_int(xs[i]);
+            yr[i] = ys[i] < 0 ? f.from_big(ys[i]) : f.from_word((uint64_t)(ys[i] % p));
+        }
+        if (!interpolate_coeffs_modp(f, xr, yr, c)) return false;
+
+        bool stable = pi > 0;
+        WordField::elem minv = f.inv(f.from_word((uint64_t)(modulus % p)));
+        cpp_int half = modulus >> 1;
+        for (int m = 0; m < k; ++m) {
+            WordField::elem v = f.from_word((uint64_t)(lift[m] % p));
+            uint64_t t = f.to_word(f.mul(f.sub(c[m], v), minv));
+            if (lift[m] <= half ? t != 0 : t != p - 1) stable = false;
+            lift[m] += modulus * t;
+        }
+        modulus *= p;
+        if (stable) {
+            half = modulus >> 1;
+            for (int m = 0; m < k; ++m) centered[m] = lift[m] > half ? lift[m] - modulus : lift[m];
+            bool fits = true;
+            for (int i = 0; i < k && fits; ++i) {
+                cpp_int acc = centered[k - 1];
+                for (int m = k - 2; m >= 0; --m) acc = acc * xs[i] + centered[m];
+                fits = acc == ys[i];
+            }
+            if (fits) {
+                out_coeff.assign(k, Frac(0, 1));
+                for (int m = 0; m < k; ++m) out_coeff[m] = Frac(centered[m], 1);
+                return true;
+            }
+        }
+        if ((size_t)msb(modulus) > bound_bits) return false;
+    }
+}
+
+// ---------- Engine dispatch ----------
+enum class Engine { Lagrange, Gauss, Bareiss, Crt };
+
+// Lex is the historical prev_permutation order; the first valid subset in the
+// chosen order decides the output.
+enum class Search { Lex, Revolving };
+
+// Per-object limits on subsets tried and wall time. Searches charge one unit per
+// subset and stop cooperatively once charge() fails; the clock is read every
+// 16 charges. Safe to share between the workers of one parallel search.
+class SearchBudget {
+public:
+    SearchBudget(double time_limit_ms, uint64_t max_combos)
+        : start_(chrono::steady_clock::now()), timed_(time_limit_ms > 0), max_combos_(max_combos) {
+        if (timed_) deadline_ = start_ + chrono::microseconds((int64_t)(time_limit_ms * 1000));
+    }
+
+    bool charge() {
+        if (hit_.load(memory_order_relaxed)) return false;
+        uint64_t n = tried_.fetch_add(1, memory_order_relaxed) + 1;
+        if ((max_combos_ && n > max_combos_) || (timed_ && n % 16 == 0 && chrono::steady_clock::now() > deadline_)) {
+            hit_.store(true, memory_order_relaxed);
+            tried_.fetch_sub(1, memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    bool exhausted() const { return hit_.load(memory_order_relaxed); }
+    uint64_t tried() const { return tried_.load(memory_order_relaxed); }
+    double elapsed_ms() const {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    chrono::steady_clock::time_point start_, deadline_;
+    bool timed_;
+    uint64_t max_combos_;
+    atomic<uint64_t> tried_{0};
+    atomic<bool> hit_{false};
+};
+
+struct SolveOptions {
+    Engine engine = Engine::Lagrange;
+    Search search = Search::Lex;
+    bool decode = false; // Reed-Solomon decoding instead of subset search
+    int threads = 1;     // workers for the lex subset search
+    int out_base = 10;   // base the constant is printed in
+    int consensus = 0;   // shares that must agree with a candidate polynomial (0 = off)
+    double time_limit_ms = 0; // per-object limits (0 = none); a hit prints TIMEOUT
+    uint64_t max_combos = 0;
+    bool prune = false; // search the shares a consistent sample agrees on first
+    bool fixed_tier = true; // small objects try SmallIntTier before the engine (off for an explicit --engine)
+    bool cache_weights = true; // use the LagrangeWeightCache; set per call by ShamirSolver::solve
+    SearchBudget *budget = nullptr; // set per call by ShamirSolver::solve
+};
+
+inline bool interpolate_and_check(const vector<int> &xs, const vector<cpp_int> &ys, vector<Frac> &out_coeff,
+                                  const SolveOptions &opt) {
+    StatTimer timer(&StatCounters::interp_ns);
+    if (g_stats_enabled) ++StatCounters::local().interp_calls;
+    switch (opt.engine) {
+    case Engine::Gauss: return interpolate_gauss(xs, ys, out_coeff);
+    case Engine::Bareiss: return interpolate_bareiss(xs, ys, out_coeff);
+    case Engine::Crt: return interpolate_crt(xs, ys, out_coeff);
+    case Engine::Lagrange: break;
+    }
+    return interpolate_lagrange(xs, ys, out_coeff, opt.cache_weights);
+}
+
+// ---------- Consensus verification ----------
+// With --consensus T an integral candidate is accepted only if at least T of
+// the n shares lie on it. Agreement is counted modulo 2^61 - 1 with word Horner
+// first, and only residue matches are confirmed exactly. A rejected candidate's
+// agreement set is remembered: every k-subset inside it interpolates the same
+// polynomial, so those subsets are skipped without solving.
+class ConsensusCheck {
+public:
+    ConsensusCheck() = default;
+    ConsensusCheck(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int threshold) {
+        reset(xs_full, ys_full, threshold);
+    }
+
+    // Starts over on another share set, keeping the residue buffers.
+    void reset(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int threshold) {
+        xs_ = &xs_full;
+        ys_ = &ys_full;
+        threshold_ = threshold;
+        xres_.clear();
+        yres_.clear();
+        rejected_.clear();
+        if (!enabled()) return;
+        for (const cpp_int &y : ys_full) yres_.push_back(mod_word(y, kP));
+        for (int x : xs_full) xres_.push_back(x < 0 ? kP - (uint64_t)(-(long long)x) % kP : (uint64_t)x % kP);
+    }
+
+    bool enabled() const { return threshold_ > 0; }
+
+    // True if idx lies inside the agreement set of a rejected candidate.
+    bool pruned(const vector<int> &idx) const {
+        for (const vector<uint64_t> &set : rejected_) {
+            bool inside = true;
+            for (int i : idx)
+                if (!(set[i >> 6] >> (i & 63) & 1)) { inside = false; break; }
+            if (inside) return true;
+        }
+        return false;
+    }
+
+    bool accept(const vector<Frac> &coeffs) {
+        const vector<int> &xs = *xs_;
+        int n = xs.size(), k = coeffs.size();
+        vector<uint64_t> cres(k);
+        for (int m = 0; m < k; ++m) cres[m] = mod_word(coeffs[m].num, kP);
+        vector<uint64_t> agree((n + 63) / 64, 0);
+        int count = 0;
+        for (int i = 0; i < n; ++i) {
+            uint64_t acc = cres[k - 1];
+            for (int m = k - 2; m >= 0; --m) acc = (mulmod_u64(acc, xres_[i], kP) + cres[m]) % kP;
+            if (acc != yres_[i]) continue;
+            cpp_int exact = coeffs[k - 1].num;
+            for (int m = k - 2; m >= 0; --m) exact = exact * xs[i] + coeffs[m].num;
+            if (exact != (*ys_)[i]) continue;
+            agree[i >> 6] |= 1ull << (i & 63);
+            ++count;
+        }
+        if (count >= threshold_) return true;
+        rejected_.push_back(std::move(agree));
+        return false;
+    }
+
+private:
+    static constexpr uint64_t kP = (1ull << 61) - 1;
+    const vector<int> *xs_ = nullptr;
+    const vector<cpp_int> *ys_ = nullptr;
+    int threshold_ = 0;
+    vector<uint64_t> xres_, yres_;
+    vector<vector<uint64_t>> rejected_;
+};
+
+// ---------- Fixed-width integer tier ----------
+// Small objects solve each subset in fixed-width integers before touching
+// cpp_int: checked __int128 when every y fits in 100 bits, checked 256-bit
+// otherwise up to 220 bits. Any overflow throws std::overflow_error; the
+// object then moves up a tier for good, and the subset falls back to the
+// exact engine, so results never depend on the tier. The tier takes precedence
+// over the default engine and is counted as interpolation in --stats; an
+// explicit --engine turns it off (SolveOptions::fixed_tier) so engines compare
+// on equal terms.
+struct Checked128 {
+    __int128 v = 0;
+    Checked128() = default;
+    Checked128(long long x) : v(x) {}
+    static Checked128 raw(__int128 x) { Checked128 c; c.v = x; return c; }
+    [[noreturn]] static void overflow() { throw overflow_error("int128 overflow"); }
+
+    friend Checked128 operator+(Checked128 a, Checked128 b) {
+        __int128 r;
+        if (__builtin_add_overflow(a.v, b.v, &r)) overflow();
+        return raw(r);
+    }
+    friend Checked128 operator-(Checked128 a, Checked128 b) {
+        __int128 r;
+        if (__builtin_sub_overflow(a.v, b.v, &r)) overflow();
+        return raw(r);
+    }
+    friend Checked128 operator*(Checked128 a, Checked128 b) {
+        __int128 r;
+        if (__builtin_mul_overflow(a.v, b.v, &r)) overflow();
+        return raw(r);
+    }
+    friend Checked128 operator/(Checked128 a, Checked128 b) { return raw(a.v / b.v); } // |b| > 1 or b == 1 here
+    friend Checked128 operator%(Checked128 a, Checked128 b) { return raw(a.v % b.v); }
+    Checked128 operator-() const { return Checked128() - *this; }
+    Checked128 &operator+=(Checked128 o) { return *this = *this + o; }
+    Checked128 &operator*=(Checked128 o) { return *this = *this * o; }
+    friend bool operator==(Checked128 a, Checked128 b) { return a.v == b.v; }
+    friend bool operator!=(Checked128 a, Checked128 b) { return a.v != b.v; }
+    friend bool operator<(Checked128 a, Checked128 b) { return a.v < b.v; }
+
+    cpp_int to_big() const {
+        unsigned __int128 m = v < 0 ? -(unsigned __int128)v : (unsigned __int128)v;
+        cpp_int r = (uint64_t)(m >> 64);
+        r <<= 64;
+        r |= (uint64_t)m;
+        return v < 0 ? cpp_int(-r) : r;
+    }
+};
+
+using Checked256 = boost::multiprecision::number<boost::multiprecision::cpp_int_backend<
+    256, 256, boost::multiprecision::signed_magnitude, boost::multiprecision::checked, void>>;
+
+inline cpp_int to_big(const Checked128 &v) { return v.to_big(); }
+inline cpp_int to_big(const Checked256 &v) { return cpp_int(v); }
+
+// The Lagrange solve of interpolate_lagrange for one subset, in I. Returns
+// false when some coefficient is not an integer; throws on overflow.
+template <class I>
+bool lagrange_fixed(const vector<int> &xs, const vector<I> &ys, vector<I> &coef, vector<I> &scratch) {
+    int k = xs.size();
+    scratch.assign(3 * k + 1, I(0));
+    I *scale = scratch.data(), *M = scale + k, *num = M + k + 1;
+    I D = 1;
+    for (int i = 0; i < k; ++i) {
+        I w = 1;
+        for (int j = 0; j < k; ++j) {
+            if (j == i) continue;
+            long long d = (long long)xs[i] - xs[j];
+            if (d == 0) return false;
+            w *= I(d);
+        }
+        scale[i] = w;
+        I a = w < I(0) ? -w : w, b = D;
+        while (a != I(0)) { I t = b % a; b = a; a = t; }
+        D = D / b * (w < I(0) ? -w : w);
+    }
+    for (int i = 0; i < k; ++i) scale[i] = D / scale[i] * ys[i];
+
+    // M(x) = prod_j (x - x_j); q_i = M / (x - x_i) by synthetic division.
+    M[0] = 1;
+    for (int j = 0; j < k; ++j) {
+        for (int t = j + 1; t > 0; --t) M[t] = M[t - 1] - M[t] * I(xs[j]);
+        M[0] = M[0] * I(-(long long)xs[j]);
+    }
+    for (int i = 0; i < k; ++i) {
+        I q = M[k];
+        for (int t = k - 1; t >= 0; --t) {
+            num[t] += scale[i] * q;
+            q = M[t] + q * I(xs[i]);
+        }
+    }
+    coef.resize(k);
+    for (int t = 0; t < k; ++t) {
+        if (num[t] % D != I(0)) return false;
+        coef[t] = num[t] / D;
+    }
+    return true;
+}
+
+// lagrange_fixed with k a template parameter. Everything that depends only on
+// the x's, the combined denominator D and the matrix L[t][i] = D / w_i * [x^t]
+// M / (x - x_i), is built in checked 64-bit integers with constant trip counts;
+// only the K^2 products with the y's and K divisions run in I. Returns 1 / 0 as
+// lagrange_fixed returns true / false, and -1 when the x-part does not fit in
+// 64 bits (the caller then uses lagrange_fixed). SmallIntTier picks the kernel
+// for each subset's k up to kUnrolledMaxK.
+constexpr int kUnrolledMaxK = 8;
+
+template <int K, class I>
+int lagrange_fixed_k(const int *xs, const I *ys, I *coef) {
+    array<long long, K> w;
+    array<long long, K + 1> M{};
+    array<array<long long, K>, K> L;
+    long long D = 1;
+    for (int i = 0; i < K; ++i) {
+        long long p = 1;
+        for (int j = 0; j < K; ++j) {
+            if (j == i) continue;
+            long long d = (long long)xs[i] - xs[j];
+            if (d == 0) return 0;
+            if (__builtin_mul_overflow(p, d, &p)) return -1;
+        }
+        w[i] = p;
+        long long a = p < 0 ? -p : p;
+        if (__builtin_mul_overflow(D / gcd(D, a), a, &D)) return -1;
+    }
+    M[0] = 1;
+    for (int j = 0; j < K; ++j) {
+        for (int t = j + 1; t > 0; --t)
+            if (__builtin_mul_overflow(M[t], (long long)xs[j], &M[t]) || __builtin_sub_overflow(M[t - 1], M[t], &M[t]))
+                return -1;
+        if (__builtin_mul_overflow(M[0], -(long long)xs[j], &M[0])) return -1;
+    }
+    for (int i = 0; i < K; ++i) {
+        long long s = D / w[i], q = M[K];
+        for (int t = K - 1; t >= 0; --t) {
+            if (__builtin_mul_overflow(s, q, &L[t][i])) return -1;
+            if (t > 0 && (__builtin_mul_overflow(q, (long long)xs[i], &q) || __builtin_add_overflow(q, M[t], &q)))
+                return -1;
+        }
+    }
+    I den = D;
+    for (int t = 0; t < K; ++t) {
+        I num = 0;
+        for (int i = 0; i < K; ++i) num += I(L[t][i]) * ys[i];
+        I c = num / den;
+        if (c * den != num) return 0;
+        coef[t] = c;
+    }
+    return 1;
+}
+
+template <class I>
+using FixedKernel = int (*)(const int *, const I *, I *);
+
+template <class I, size_t... K>
+constexpr array<FixedKernel<I>, sizeof...(K)> fixed_kernels(index_sequence<K...>) {
+    return {&lagrange_fixed_k<int(K), I>...};
+}
+
+// The unrolled kernel for k, or nullptr when k is above kUnrolledMaxK.
+template <class I>
+FixedKernel<I> fixed_kernel(size_t k) {
+    static constexpr auto table = fixed_kernels<I>(make_index_sequence<kUnrolledMaxK + 1>());
+    return k < table.size() ? table[k] : nullptr;
+}
+
+class SmallIntTier {
+public:
+    SmallIntTier() = default;
+    SmallIntTier(const vector<int> &xs_full, const vector<cpp_int> &ys_full) { reset(xs_full, ys_full); }
+
+    // Picks the tier for another share set, keeping the buffers.
+    void reset(const vector<int> &xs_full, const vector<cpp_int> &ys_full) {
+        xs_full_ = &xs_full;
+        tier_ = Wide;
+        y128_.clear();
+        y256_.clear();
+        unsigned bits = 0;
+        for (const cpp_int &y : ys_full) {
+            if (y < 0) { tier_ = None; return; }
+            if (y != 0) bits = max(bits, (unsigned)msb(y) + 1);
+        }
+        if (bits > 220) { tier_ = None; return; }
+        for (const cpp_int &y : ys_full) y256_.push_back(Checked256(y));
+        if (bits <= 100) {
+            tier_ = Small;
+            for (const cpp_int &y : ys_full) {
+                cpp_int lo = y & cpp_int(UINT64_MAX), hi = y >> 64;
+                y128_.push_back(Checked128::raw(((__int128)(uint64_t)hi << 64) | (uint64_t)lo));
+            }
+        }
+    }
+
+    bool active() const { return tier_ != None; }
+
+    // 1 / 0: the subset's interpolant is / is not integral (coeffs filled on 1);
+    // -1: overflow, solve it exactly instead.
+    int solve(const vector<int> &idx, vector<Frac> &coeffs) {
+        xs_.resize(idx.size());
+        for (size_t i = 0; i < idx.size(); ++i) xs_[i] = (*xs_full_)[idx[i]];
+        while (tier_ != None) {
+            try {
+                return tier_ == Small ? run(idx, y128_, s128_, coeffs) : run(idx, y256_, s256_, coeffs);
+            } catch (const overflow_error &) {
+                tier_ = tier_ == Small ? Wide : None;
+                return -1;
+            }
+        }
+        return -1;
+    }
+
+private:
+    template <class I>
+    struct Scratch { vector<I> ys, coef, work; };
+
+    template <class I>
+    int run(const vector<int> &idx, const vector<I> &yfull, Scratch<I> &sc, vector<Frac> &coeffs) {
+        sc.ys.resize(idx.size());
+        for (size_t i = 0; i < idx.size(); ++i) sc.ys[i] = yfull[idx[i]];
+        FixedKernel<I> kernel = fixed_kernel<I>(idx.size());
+        int fast = -1;
+        if (kernel) {
+            sc.coef.resize(idx.size());
+            fast = kernel(xs_.data(), sc.ys.data(), sc.coef.data());
+        }
+        if (fast == 0 || (fast < 0 && !lagrange_fixed(xs_, sc.ys, sc.coef, sc.work))) return 0;
+        coeffs.resize(sc.coef.size());
+        for (size_t t = 0; t < sc.coef.size(); ++t) {
+            coeffs[t] = Frac(to_big(sc.coef[t]), 1);
+            stat_bits(coeffs[t].num);
+        }
+        return 1;
+    }
+
+    enum Tier { None, Wide, Small };
+    const vector<int> *xs_full_ = nullptr;
+    Tier tier_ = None;
+    vector<Checked128> y128_;
+    vector<Checked256> y256_;
+    vector<int> xs_;
+    Scratch<Checked128> s128_;
+    Scratch<Checked256> s256_;
+};
+
+// Everything one search does to decide a subset, cheapest first: consensus
+// pruning, the integrality screen, the fixed-width tier, then (when the tier
+// overflowed) an optional caller filter and the exact engine, and finally the
+// consensus vote. One per thread; reset() moves it to the next share set
+// without giving up its buffers.
+class SubsetSolver {
+public:
+    SubsetSolver() = default;
+    SubsetSolver(const vector<int> &xs_full, const vector<cpp_int> &ys_full, const SolveOptions &opt) {
+        reset(xs_full, ys_full, opt);
+    }
+
+    // The share vectors and opt must outlive the calls up to the next reset.
+    void reset(const vector<int> &xs_full, const vector<cpp_int> &ys_full, const SolveOptions &opt) {
+        xs_full_ = &xs_full;
+        ys_full_ = &ys_full;
+        opt_ = &opt;
+        tier_.reset(xs_full, ys_full);
+        screen_.reset(xs_full, ys_full, opt.cache_weights);
+        consensus_.reset(xs_full, ys_full, opt.consensus);
+        dup_x_ = false;
+        if (is_sorted(xs_full.begin(), xs_full.end())) { // the parsers' order: no sort needed
+            dup_x_ = adjacent_find(xs_full.begin(), xs_full.end()) != xs_full.end();
+            if (!dup_x_) return;
+        }
+        order_.resize(xs_full.size());
+        iota(order_.begin(), order_.end(), 0);
+        stable_sort(order_.begin(), order_.end(), [&](int a, int b) { return xs_full[a] < xs_full[b]; });
+        xclass_.resize(xs_full.size());
+        for (size_t r = 0; r < order_.size(); ++r) {
+            bool same = r > 0 && xs_full[order_[r]] == xs_full[order_[r - 1]];
+            xclass_[order_[r]] = same ? xclass_[order_[r - 1]] : order_[r];
+            dup_x_ |= same;
+        }
+        if (dup_x_) seen_.assign(xs_full.size(), 0);
+    }
+
+    // idx: share indices. On true, coeffs() holds the integral interpolant.
+    template <class Filter>
+    bool accept(const vector<int> &idx, Filter &&filter) {
+        if (dup_x_ && repeats_x(idx)) return false;
+        if (consensus_.enabled() && consensus_.pruned(idx)) return false;
+        if (!screen_.may_pass(idx)) return false;
+        int verdict = -1;
+        if (opt_->fixed_tier && tier_.active()) {
+            StatTimer timer(&StatCounters::interp_ns);
+            if (g_stats_enabled) ++StatCounters::local().interp_calls;
+            verdict = tier_.solve(idx, coeffs_);
+        }
+        if (verdict == 0) return false;
+        if (verdict < 0) {
+            if (!filter()) return false;
+            xs_.resize(idx.size());
+            ys_.resize(idx.size());
+            for (size_t i = 0; i < idx.size(); ++i) { xs_[i] = (*xs_full_)[idx[i]]; ys_[i] = (*ys_full_)[idx[i]]; }
+            if (!interpolate_and_check(xs_, ys_, coeffs_, *opt_)) return false;
+        }
+        return !consensus_.enabled() || consensus_.accept(coeffs_);
+    }
+    bool accept(const vector<int> &idx) { return accept(idx, [] { return true; }); }
+
+    const vector<Frac> &coeffs() const { return coeffs_; }
+
+private:
+    // Two shares with one x make the system singular, whatever their y, so
+    // such subsets are rejected before any arithmetic. Shares with equal x
+    // share an xclass_, marked in seen_ as idx is walked, so neither the
+    // share order nor the order of idx (the revolving door's slot order)
+    // matters.
+    bool repeats_x(const vector<int> &idx) {
+        bool repeat = false;
+        size_t i = 0;
+        for (; i < idx.size() && !repeat; ++i) repeat = exchange(seen_[xclass_[idx[i]]], 1) != 0;
+        while (i > 0) seen_[xclass_[idx[--i]]] = 0;
+        return repeat;
+    }
+
+    const vector<int> *xs_full_ = nullptr;
+    const vector<cpp_int> *ys_full_ = nullptr;
+    const SolveOptions *opt_ = nullptr;
+    SmallIntTier tier_;
+    IntegralityScreen screen_;
+    ConsensusCheck consensus_;
+    bool dup_x_ = false;
+    vector<int> order_;
+    vector<int> xclass_; // per share, the index of the first share with its x (only with dup_x_)
+    vector<char> seen_;
+    vector<int> xs_;
+    vector<cpp_int> ys_;
+    vector<Frac> coeffs_;
+};
+
+// ---------- Iterate combinations ----------
+// Subsets queued kLanes at a time for AdicBatchScreen, then handed to the
+// solver in queue order. Each subset is charged to the budget and counted as
+// its batch is flushed, so limits and --stats see exactly the subsets looked
+// at, as in the one-at-a-time search.
+class SubsetBatch {
+public:
+    enum class Outcome { None, Found, Stopped };
+
+    explicit SubsetBatch(const AdicBatchScreen &screen) : screen_(screen) {}
+    SubsetBatch(const AdicBatchScreen &screen, int k) : screen_(screen) { reset(k); }
+
+    // Empties the queue for subsets of k shares.
+    void reset(int k) {
+        k_ = k;
+        count_ = 0;
+        queued_.resize(AdicBatchScreen::kLanes * k);
+        idx_.resize(k);
+    }
+
+    // Slot for the next subset's k share indices.
+    int *push() { return queued_.data() + count_++ * k_; }
+    bool full() const { return count_ == AdicBatchScreen::kLanes; }
+
+    // Looks at the first `limit` queued subsets and empties the queue. On
+    // Found, `lane` is the position of the accepted subset.
+    Outcome flush(SubsetSolver &solver, SearchBudget *budget, int &lane, int limit = AdicBatchScreen::kLanes) {
+        int count = min(count_, limit);
+        count_ = 0;
+        if (count <= 0) return Outcome::None;
+        unsigned alive = screen_.screen(queued_.data(), count, k_);
+        for (int l = 0; l < count; ++l) {
+            if (budget && !budget->charge()) return Outcome::Stopped;
+            stat_combo_tried();
+            if (!(alive >> l & 1)) continue;
+            idx_.assign(queued_.begin() + l * k_, queued_.begin() + (l + 1) * k_);
+            if (solver.accept(idx_)) {
+                lane = l;
+                return Outcome::Found;
+            }
+        }
+        return Outcome::None;
+    }
+
+private:
+    const AdicBatchScreen &screen_;
+    int k_ = 0, count_ = 0;
+    vector<int> queued_, idx_;
+};
+
+// What a lex or revolving-door search builds per share set, kept by
+// ShamirSolver across calls so that a warm solver reuses every buffer.
+struct SearchScratch {
+    SearchScratch() = default;
+    SearchScratch(const SearchScratch &) = delete; // batch refers to screen
+    SearchScratch &operator=(const SearchScratch &) = delete;
+
+    SubsetSolver solver;
+    AdicBatchScreen screen;
+    SubsetBatch batch{screen};
+    vector<int> choose, idx;
+};
+
+inline bool find_valid_constant(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                                cpp_int &constant_out, const SolveOptions &opt, SearchScratch &scratch) {
+    int n = (int)xs_full.size();
+    if (k > n) return false;
+
+    vector<int> &choose = scratch.choose;
+    choose.assign(n, 0);
+    for (int i = 0; i < k; ++i) choose[i] = 1;
+
+    stat_combos(n, k);
+    SubsetSolver &solver = scratch.solver;
+    solver.reset(xs_full, ys_full, opt);
+    AdicBatchScreen &screen = scratch.screen;
+    screen.reset(xs_full, ys_full, k);
+    if (screen.enabled()) {
+        SubsetBatch &batch = scratch.batch;
+        batch.reset(k);
+        SubsetBatch::Outcome out = SubsetBatch::Outcome::None;
+        int lane;
+        do {
+            int *slot = batch.push();
+            for (int i = 0; i < n; ++i) if (choose[i]) *slot++ = i;
+            if (batch.full() && (out = batch.flush(solver, opt.budget, lane)) != SubsetBatch::Outcome::None) break;
+        } while (prev_permutation(choose.begin(), choose.end()));
+        if (out == SubsetBatch::Outcome::None) out = batch.flush(solver, opt.budget, lane);
+        if (out != SubsetBatch::Outcome::Found) return false;
+        constant_out = solver.coeffs()[0].num;
+        return true;
+    }
+    vector<int> &idx = scratch.idx;
+    do {
+        if (opt.budget && !opt.budget->charge()) return false;
+        stat_combo_tried();
+        idx.clear();
+        for (int i = 0; i < n; ++i) if (choose[i]) idx.push_back(i);
+        if (solver.accept(idx)) {
+            constant_out = solver.coeffs()[0].num;
+            return true;
+        }
+    } while (prev_permutation(choose.begin(), choose.end()));
+    return false;
+}
+
+// ---------- Parallel subset search ----------
+// The lex order of find_valid_constant is ranked with the combinatorial number
+// system, so a worker can unrank the first subset of any rank range and step
+// through it with the lex successor. Each worker owns a range and consumes it
+// from the front in small chunks; an idle worker steals the back half of the
+// largest remaining range. The lowest valid rank seen so far is published
+// atomically and nobody looks past it, so the answer is the same subset the
+// sequential search would return.
+struct RankTable {
+    vector<vector<uint64_t>> c; // c[m][j] = C(m, j), saturated at UINT64_MAX
+    RankTable(int n, int k) : c(n + 1, vector<uint64_t>(k + 1, 0)) {
+        for (int m = 0; m <= n; ++m) {
+            c[m][0] = 1;
+            for (int j = 1; j <= min(m, k); ++j) {
+                uint64_t a = c[m - 1][j - 1], b = j <= m - 1 ? c[m - 1][j] : 0;
+                c[m][j] = a > UINT64_MAX - b ? UINT64_MAX : a + b;
+            }
+        }
+    }
+    // the rank-th k-subset of {0..n-1} in lex order
+    void unrank(int n, int k, uint64_t rank, vector<int> &out) const {
+        out.resize(k);
+        int v = 0;
+        for (int i = 0; i < k; ++i, ++v) {
+            while (rank >= c[n - v - 1][k - i - 1]) { rank -= c[n - v - 1][k - i - 1]; ++v; }
+            out[i] = v;
+        }
+    }
+};
+
+inline bool next_combination(int n, vector<int> &comb) {
+    int k = comb.size(), i = k - 1;
+    while (i >= 0 && comb[i] == n - k + i) --i;
+    if (i < 0) return false;
+    ++comb[i];
+    for (int j = i + 1; j < k; ++j) comb[j] = comb[j - 1] + 1;
+    return true;
+}
+
+inline bool find_valid_constant_parallel(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                                         cpp_int &constant_out, const SolveOptions &opt, SearchScratch &scratch) {
+    int n = (int)xs_full.size();
+    if (k > n) return false;
+    RankTable table(n, k);
+    uint64_t total = table.c[n][k];
+    int workers = (int)min<uint64_t>((uint64_t)opt.threads, total);
+    if (total == UINT64_MAX || workers <= 1) return find_valid_constant(xs_full, ys_full, k, constant_out, opt, scratch);
+    stat_combos(n, k);
+    vector<StatCounters> worker_stats(workers); // merged into this thread after the join
+
+    struct Range {
+        mutex mu;
+        uint64_t lo = 0, hi = 0;
+    };
+    vector<Range> ranges(workers);
+    for (int w = 0; w < workers; ++w) {
+        ranges[w].lo = total / workers * w;
+        ranges[w].hi = w + 1 == workers ? total : total / workers * (w + 1);
+    }
+    const uint64_t chunk = max<uint64_t>(1, min<uint64_t>(256, total / ((uint64_t)workers * 64)));
+    atomic<uint64_t> best(UINT64_MAX);
+    mutex best_mu;
+    cpp_int best_constant;
+
+    auto take = [&](int self, uint64_t &lo, uint64_t &hi) {
+        {
+            lock_guard<mutex> lock(ranges[self].mu);
+            Range &r = ranges[self];
+            if (r.lo < r.hi && r.lo < best.load()) {
+                lo = r.lo;
+                hi = min(r.hi, r.lo + chunk);
+                r.lo = hi;
+                return true;
+            }
+            r.lo = r.hi;
+        }
+        while (true) { // steal the back half of the largest remaining range
+            int victim = -1;
+            uint64_t most = 0;
+            for (int w = 0; w < workers; ++w) {
+                if (w == self) continue;
+                lock_guard<mutex> lock(ranges[w].mu);
+                uint64_t hi_w = min(ranges[w].hi, best.load());
+                if (ranges[w].lo < hi_w && hi_w - ranges[w].lo > most) { most = hi_w - ranges[w].lo; victim = w; }
+            }
+            if (victim < 0) return false;
+            uint64_t s_lo, s_hi;
+            {
+                lock_guard<mutex> lock(ranges[victim].mu);
+                Range &r = ranges[victim];
+                if (r.lo >= r.hi) continue;
+                s_lo = r.lo + (r.hi - r.lo) / 2;
+                s_hi = r.hi;
+                r.hi = s_lo;
+            }
+            lock_guard<mutex> lock(ranges[self].mu);
+            ranges[self].lo = s_lo;
+            ranges[self].hi = s_hi;
+            if (s_lo < s_hi) {
+                lo = s_lo;
+                hi = min(s_hi, s_lo + chunk);
+                ranges[self].lo = hi;
+                return true;
+            }
+        }
+    };
+
+    auto found = [&](uint64_t rank, const SubsetSolver &solver) {
+        lock_guard<mutex> lock(best_mu);
+        if (rank < best.load()) { best.store(rank); best_constant = solver.coeffs()[0].num; }
+    };
+    auto work = [&](int self) {
+        vector<int> comb;
+        // Per worker; consensus pruning is only a shortcut.
+        SubsetSolver solver(xs_full, ys_full, opt);
+        AdicBatchScreen screen(xs_full, ys_full, k);
+        SubsetBatch batch(screen, k);
+        uint64_t lo, hi;
+        while (!(opt.budget && opt.budget->exhausted()) && take(self, lo, hi)) {
+            table.unrank(n, k, lo, comb);
+            if (screen.enabled()) { // the chunk in kLanes groups, each cut off at the best rank
+                for (uint64_t base = lo; base < hi;) {
+                    uint64_t end = min<uint64_t>(hi, base + AdicBatchScreen::kLanes);
+                    for (uint64_t rank = base; rank < end; ++rank) {
+                        copy(comb.begin(), comb.end(), batch.push());
+                        next_combination(n, comb);
+                    }
+                    uint64_t cut = best.load(memory_order_relaxed);
+                    int lane;
+                    int limit = cut <= base ? 0 : (int)(min(end, cut) - base);
+                    SubsetBatch::Outcome out = batch.flush(solver, opt.budget, lane, limit);
+                    if (out == SubsetBatch::Outcome::Found) found(base + lane, solver);
+                    if (out != SubsetBatch::Outcome::None || cut < end) break;
+                    base = end;
+                }
+                continue;
+            }
+            for (uint64_t rank = lo; rank < hi && rank < best.load(memory_order_relaxed); ++rank) {
+                if (opt.budget && !opt.budget->charge()) break;
+                stat_combo_tried();
+                if (solver.accept(comb)) {
+                    found(rank, solver);
+                    break;
+                }
+                next_combination(n, comb);
+            }
+        }
+        if (self != 0 && g_stats_enabled) worker_stats[self] = StatCounters::local();
+    };
+    vector<thread> pool;
+    for (int w = 1; w < workers; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (auto &t : pool) t.join();
+    if (g_stats_enabled)
+        for (int w = 1; w < workers; ++w) StatCounters::local().merge(worker_stats[w]);
+
+    // A subset found before the budget ran out is an answer, as in the
+    // sequential search; it is the lowest-ranked valid one among those tried.
+    if (best.load() == UINT64_MAX) return false;
+    constant_out = best_constant;
+    return true;
+}
+
+// ---------- Revolving-door combination order ----------
+// Knuth's Algorithm R (TAOCP 7.2.1.3): consecutive k-subsets of {0..n-1} differ
+// by exchanging a single element, starting from {0..k-1}.
+struct RevolvingDoor {
+    int n, t;
+    vector<int> c; // c[1..t] is the current subset, ascending; c[t+1] = n
+    RevolvingDoor(int n_, int t_) : n(n_), t(t_), c(t_ + 2) {
+        for (int j = 1; j <= t; ++j) c[j] = j - 1;
+        c[t + 1] = n;
+    }
+    // Moves to the next subset, reporting the one element swapped out and in.
+    bool next(int &removed, int &added) {
+        if (t & 1) {
+            if (c[1] + 1 < c[2]) { removed = c[1]; added = ++c[1]; return true; }
+        } else {
+            if (c[1] > 0) { removed = c[1]; added = --c[1]; return true; }
+        }
+        bool decrease = t & 1;
+        for (int j = 2; j <= t; ++j, decrease = !decrease) {
+            if (decrease) { // here c[j] == c[j-1] + 1
+                if (c[j] >= j) {
+                    removed = c[j]; added = j - 2;
+                    c[j] = c[j - 1]; c[j - 1] = j - 2;
+                    return true;
+                }
+            } else {        // here c[j-1] == j - 2
+                if (c[j] + 1 < c[j + 1]) {
+                    removed = j - 2; added = c[j] + 1;
+                    c[j - 1] = c[j]; ++c[j];
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+
+// q *= a / b for a reduced q and nonzero word-sized a, b; stays reduced using
+// only big-by-word remainders (gcd(q.num*a, q.den*b) = gcd(q.num, b) * gcd(a, q.den)).
+inline void mul_small_ratio(Frac &q, long long a, long long b) {
+    if (b < 0) { a = -a; b = -b; }
+    long long g = std::gcd(a, b);
+    a /= g; b /= g;
+    long long g1 = std::gcd((long long)(q.den % (a < 0 ? -a : a)), a < 0 ? -a : a);
+    long long g2 = std::gcd((long long)(abs(q.num) % b), b);
+    q.num = q.num / g2 * (a / g1);
+    q.den = q.den / g1 * (b / g2);
+}
+
+// Walks the subsets in revolving-door order while maintaining the Lagrange
+// weights at zero, lambda_i = prod_{j!=i} x_j / (x_j - x_i), across swaps:
+// dropping x_a and adding x_b rescales every surviving weight by
+// x_b (x_a - x_i) / (x_a (x_b - x_i)), so f(0) costs O(k) per step and only
+// subsets with integral f(0) reach the full interpolation engine. Shares at
+// x = 0 or repeated x make the rescaling undefined; those searches re-solve
+// every subset from scratch in the same order.
+inline bool find_valid_constant_revolving(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                                          cpp_int &constant_out, const SolveOptions &opt, SearchScratch &scratch) {
+    int n = (int)xs_full.size();
+    if (k > n) return false;
+    bool incremental = true;
+    {
+        vector<int> sorted_xs(xs_full);
+        sort(sorted_xs.begin(), sorted_xs.end());
+        if (adjacent_find(sorted_xs.begin(), sorted_xs.end()) != sorted_xs.end()) incremental = false;
+        if (binary_search(sorted_xs.begin(), sorted_xs.end(), 0)) incremental = false;
+    }
+
+    vector<int> member(k), slot_of(n, -1);
+    for (int i = 0; i < k; ++i) { member[i] = i; slot_of[i] = i; }
+    vector<Frac> lam(k);
+    auto fresh_weight = [&](int s) {
+        cpp_int num = 1, den = 1;
+        long long xi = xs_full[member[s]];
+        for (int t = 0; t < k; ++t) {
+            if (t == s) continue;
+            long long xj = xs_full[member[t]];
+            num *= xj;
+            den *= xj - xi;
+        }
+        lam[s] = Frac(num, den);
+    };
+    if (incremental) for (int s = 0; s < k; ++s) fresh_weight(s);
+
+    RevolvingDoor door(n, k);
+    SubsetSolver &solver = scratch.solver;
+    solver.reset(xs_full, ys_full, opt);
+    stat_combos(n, k);
+    while (true) {
+        if (opt.budget && !opt.budget->charge()) return false;
+        stat_combo_tried();
+        auto f0_integral = [&] { // f(0) over the lcm of the weight denominators
+            if (!incremental) return true;
+            cpp_int L = 1, f0 = 0;
+            for (int s = 0; s < k; ++s) L = L / boost::multiprecision::gcd(L, lam[s].den) * lam[s].den;
+            for (int s = 0; s < k; ++s) f0 += ys_full[member[s]] * lam[s].num * (L / lam[s].den);
+            return f0 % L == 0;
+        };
+        if (solver.accept(member, f0_integral)) {
+            constant_out = solver.coeffs()[0].num;
+            return true;
+        }
+
+        int out, in;
+        if (!door.next(out, in)) return false;
+        int s = slot_of[out];
+        slot_of[out] = -1;
+        slot_of[in] = s;
+        member[s] = in;
+        if (!incremental) continue;
+        long long xa = xs_full[out], xb = xs_full[in];
+        for (int t = 0; t < k; ++t) {
+            if (t == s) continue;
+            long long xi = xs_full[member[t]];
+            mul_small_ratio(lam[t], xb * (xa - xi), xa * (xb - xi));
+        }
+        fresh_weight(s);
+    }
+}
+
+// ---------- Reconstruction over GF(p) ----------
+// f(0) = sum_i y_i * prod_{j!=i} x_j / (x_j - x_i). The k denominators are
+// inverted together (Montgomery's batch trick), so each subset costs O(k^2)
+// multiplications and a single exponentiation.
+template <class F>
+bool interpolate_at_zero_modp(const F &f, const vector<typename F::elem> &xs, const vector<typename F::elem> &ys,
+                              typename F::elem &out) {
+    using E = typename F::elem;
+    int k = xs.size();
+    vector<E> den(k, f.one());
+    for (int i = 0; i < k; ++i)
+        for (int j = 0; j < k; ++j)
+            if (j != i) den[i] = f.mul(den[i], f.sub(xs[i], xs[j]));
+    if (!batch_invert(f, den)) return false;
+    vector<E> suffix_x(k + 1, f.one());
+    for (int j = k - 1; j >= 0; --j) suffix_x[j] = f.mul(suffix_x[j + 1], f.neg(xs[j]));
+    E acc = f.zero(), prefix_x = f.one();
+    for (int i = 0; i < k; ++i) {
+        E term = f.mul(ys[i], f.mul(prefix_x, suffix_x[i + 1]));
+        acc = f.add(acc, f.mul(term, den[i]));
+        prefix_x = f.mul(prefix_x, f.neg(xs[i]));
+    }
+    out = acc;
+    return true;
+}
+
+template <class F>
+bool find_constant_modp(const F &f, const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                        cpp_int &constant_out, SearchBudget *budget) {
+    using E = typename F::elem;
+    int n = (int)xs_full.size();
+    if (k > n) return false;
+    vector<E> xr(n), yr(n);
+    for (int i = 0; i < n; ++i) { xr[i] = f.from_int(xs_full[i]); yr[i] = f.from_big(ys_full[i]); }
+
+    vector<int> choose(n, 0);
+    for (int i = 0; i < k; ++i) choose[i] = 1;
+    sort(choose.begin(), choose.end(), greater<int>());
+
+    stat_combos(n, k);
+    vector<E> xs, ys;
+    xs.reserve(k); ys.reserve(k);
+    do {
+        if (budget && !budget->charge()) return false;
+        stat_combo_tried();
+        xs.clear(); ys.clear();
+        for (int i = 0; i < n; ++i) if (choose[i]) { xs.push_back(xr[i]); ys.push_back(yr[i]); }
+        E c;
+        if (interpolate_at_zero_modp(f, xs, ys, c)) {
+            constant_out = f.to_big(c);
+            return true;
+        }
+    } while (prev_permutation(choose.begin(), choose.end()));
+    return false;
+}
+
+// Calls fn with the field type matching the size of the prime (false if not prime).
+template <class Fn>
+bool with_prime_field(const cpp_int &prime, Fn &&fn) {
+    if (prime < 2 || !miller_rabin_test(prime, 25)) return false;
+    if (prime == 2) return fn(BigField(prime));
+    unsigned bits = (unsigned)msb(prime) + 1;
+    if (bits <= 256) return fn(FieldFor<256>::type(prime));
+    if (bits <= 576) return fn(FieldFor<521>::type(prime));
+    return fn(FieldFor<0>::type(prime));
+}
+
+// Every subset with distinct x (mod p) interpolates in a field, so the first one wins.
+inline bool find_valid_constant_modp(const cpp_int &prime, const vector<int> &xs_full, const vector<cpp_int> &ys_full,
+                                     int k, cpp_int &constant_out, SearchBudget *budget = nullptr) {
+    return with_prime_field(prime, [&](const auto &f) {
+        return find_constant_modp(f, xs_full, ys_full, k, constant_out, budget);
+    });
+}
+
+// ---------- Reed-Solomon decoding (Gao) ----------
+// With n shares of a degree < k polynomial, up to (n - k) / 2 corrupted shares
+// are corrected in O(n^2): interpolate all n points to g1, run the extended
+// Euclidean algorithm on (prod (x - x_i), g1) until the remainder has degree
+// below (n + k) / 2, and divide that remainder by its Bezout cofactor (the
+// error locator). 'bad' receives the positions where the decoded polynomial
+// disagrees with the share.
+template <class F, class E = typename F::elem>
+bool gao_decode(const F &f, const vector<E> &xs, const vector<E> &ys, int k, vector<E> &poly, vector<int> &bad) {
+    int n = xs.size();
+    if (k > n) return false;
+    vector<E> g1;
+    if (!interpolate_coeffs_modp(f, xs, ys, g1)) return false;
+    poly_trim(f, g1);
+    vector<E> g0(1, f.one());
+    for (const E &x : xs) g0 = poly_mul(f, g0, vector<E>{f.neg(x), f.one()});
+
+    vector<E> r0 = g0, r1 = g1, v0, v1(1, f.one()), q, r;
+    while (2 * ((int)r1.size() - 1) >= n + k) {
+        poly_divmod(f, r0, r1, q, r);
+        vector<E> v2 = poly_sub(f, v0, poly_mul(f, q, v1));
+        r0 = move(r1); r1 = move(r);
+        v0 = move(v1); v1 = move(v2);
+    }
+    poly_divmod(f, r1, v1, poly, r);
+    if (!r.empty() || (int)poly.size() > k) return false;
+
+    bad.clear();
+    for (int i = 0; i < n; ++i) {
+        E d = f.sub(poly_eval(f, poly, xs[i]), ys[i]);
+        if (!f.is_zero(d)) bad.push_back(i);
+    }
+    return 2 * (int)bad.size() <= n - k;
+}
+
+// GF(p) objects decode directly in their own field.
+inline bool decode_shares_modp(const cpp_int &prime, const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                               cpp_int &constant_out, vector<int> &bad_out) {
+    return with_prime_field(prime, [&](const auto &f) {
+        using E = typename decay_t<decltype(f)>::elem;
+        int n = xs_full.size();
+        vector<E> xr(n), yr(n), poly;
+        for (int i = 0; i < n; ++i) { xr[i] = f.from_int(xs_full[i]); yr[i] = f.from_big(ys_full[i]); }
+        vector<int> bad;
+        if (!gao_decode(f, xr, yr, k, poly, bad)) return false;
+        constant_out = poly.empty() ? cpp_int(0) : f.to_big(poly[0]);
+        bad_out.clear();
+        for (int i : bad) bad_out.push_back(xs_full[i]);
+        return true;
+    });
+}
+
+// Integer shares decode modulo a word prime, which finds the corrupted positions;
+// the polynomial itself is then rebuilt exactly from k of the remaining shares and
+// checked against all of them. A share that happens to agree modulo p but not over
+// Z fails that check, and the next prime is tried.
+inline bool decode_shares_integer(const vector<int> &xs_full, const vector<cpp_int> &ys_full, int k,
+                                  cpp_int &constant_out, vector<int> &bad_out, const SolveOptions &opt) {
+    int n = xs_full.size();
+    if (k > n) return false;
+    for (size_t attempt = 0; attempt < 3; ++attempt) {
+        const WordField &f = word_prime(attempt);
+        vector<WordField::elem> xr(n), yr(n), poly;
+        for (int i = 0; i < n; ++i) { xr[i] = f.from_int(xs_full[i]); yr[i] = f.from_big(ys_full[i]); }
+        vector<int> bad;
+        if (!gao_decode(f, xr, yr, k, poly, bad)) return false;
+
+        vector<int> good;
+        for (int i = 0, b = 0; i < n; ++i) {
+            if (b < (int)bad.size() && bad[b] == i) { ++b; continue; }
+            good.push_back(i);
+        }
+        vector<int> xs(k);
+        vector<cpp_int> ys(k);
+        for (int i = 0; i < k; ++i) { xs[i] = xs_full[good[i]]; ys[i] = ys_full[good[i]]; }
+        vector<Frac> coeffs;
+        if (!interpolate_and_check(xs, ys, coeffs, opt)) continue;
+        bool consistent = true;
+        for (size_t g = k; g < good.size() && consistent; ++g) {
+            cpp_int acc = coeffs[k - 1].num;
+            for (int m = k - 2; m >= 0; --m) acc = acc * xs_full[good[g]] + coeffs[m].num;
+            consistent = acc == ys_full[good[g]];
+        }
+        if (!consistent) continue;
+        constant_out = coeffs[0].num;
+        bad_out.clear();
+        for (int i : bad) bad_out.push_back(xs_full[i]);
+        return true;
+    }
+    return false;
+}
+
+// ---------- Big integer to text ----------
+// Power-of-two bases read digits straight out of the limbs. Other bases peel m
+// digits per division by base^m < 2^64 (a single-limb divisor; m = 19 for
+// decimal), and values past a few dozen limbs are first split in half at the
+// cached chunk powers base^(m * 2^j) shared with the decoder, so the divisions
+// stay balanced instead of shaving one chunk at a time off a huge number.
+static const char *const kDigitChars = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// Appends v >= 0 in base; pad > 0 left-fills with zeros to exactly pad digits.
+inline void append_digits(const cpp_int &v, int base, ChunkInfo info, size_t pad, string &out) {
+    const size_t split_bits = 64 * 32;
+    size_t bits = v == 0 ? 0 : (size_t)msb(v) + 1;
+    if (bits > split_bits) {
+        size_t j = 0;
+        while (2 * ((size_t)msb(chunk_power(base, j + 1)) + 1) <= bits) ++j;
+        size_t low_digits = (size_t)info.digits << j;
+        cpp_int q, r;
+        divide_qr(v, chunk_power(base, j), q, r);
+        append_digits(q, base, info, pad > low_digits ? pad - low_digits : 0, out);
+        append_digits(r, base, info, low_digits, out);
+        return;
+    }
+    vector<uint64_t> chunks; // least significant first
+    cpp_int t = v, q, r;
+    const cpp_int P = info.power;
+    while (t != 0) {
+        divide_qr(t, P, q, r);
+        chunks.push_back((uint64_t)r);
+        t.swap(q);
+    }
+    char buf[64];
+    string digits;
+    for (size_t c = chunks.size(); c-- > 0;) {
+        uint64_t x = chunks[c];
+        int len = 0;
+        for (; x; x /= (uint64_t)base) buf[len++] = kDigitChars[x % (uint64_t)base];
+        int width = c + 1 == chunks.size() ? len : info.digits;
+        for (int i = len; i < width; ++i) digits.push_back('0');
+        while (len) digits.push_back(buf[--len]);
+    }
+    if (pad > digits.size()) out.append(pad - digits.size(), '0');
+    out += digits;
+}
+
+inline string cpp_int_to_string(const cpp_int &v, int base = 10) {
+    if (base < 2 || base > 36) throw runtime_error("output base must be in 2..36");
+    if (v == 0) return "0";
+    string s;
+    if (v < 0) s.push_back('-');
+    cpp_int t = abs(v);
+    if ((base & (base - 1)) == 0) {
+        unsigned bits = 0;
+        while ((1 << bits) < base) ++bits;
+        vector<unsigned char> digits;
+        export_bits(t, back_inserter(digits), bits, true);
+        for (unsigned char d : digits) s.push_back(kDigitChars[d]);
+        return s;
+    }
+    append_digits(t, base, chunk_info((uint64_t)base), 0, s);
+    return s;
+}
+
+// ---------- Consistency pruning ----------
+// With --prune an exact search first looks for k + 1 shares that lie on one
+// polynomial of degree < k modulo a word prime p: their k-th divided
+// difference sum_i y_i / prod_{j!=i} (x_i - x_j) vanishes. Sliding windows
+// are tried first, then seeded random samples. Shares with a repeated x are
+// left out. A window holding a bad share passes only with probability about
+// 1/p, so the window's interpolant mod p is taken as the true one and every
+// share is checked against it in O(k). With e bad shares that costs about
+// (n / (n - e))^(k+1) windows instead of up to C(n, k) exact solves.
+// All shares agreeing in one polynomial means any k of them give the same
+// interpolant, so only the first k in x order are solved exactly. If no
+// window agrees, or that candidate is not integral, the full search runs
+// as usual. The pruned answer can come from a later lex subset than the
+// plain search would take, since a bad share can still be part of an
+// integral subset by chance. GF(p) objects always accept their first subset,
+// so pruning does not apply to them.
+inline bool consistent_shares(const vector<int> &xs, const vector<cpp_int> &ys, int k, vector<int> &keep) {
+    int n = (int)xs.size();
+    if (k < 1 || n <= k) return false;
+    const WordField &f = word_prime(0);
+    using E = WordField::elem;
+    vector<int> ok; // shares whose x occurs once
+    for (int i = 0; i < n; ++i)
+        if ((i == 0 || xs[i] != xs[i - 1]) && (i + 1 == n || xs[i] != xs[i + 1])) ok.push_back(i);
+    if ((int)ok.size() <= k) return false;
+    vector<E> fx(n), fy(n);
+    for (int i : ok) {
+        fx[i] = f.from_int(xs[i]);
+        fy[i] = f.from_big(ys[i]);
+    }
+
+    vector<int> win(k + 1);
+    vector<E> w(k + 1);
+    auto consistent = [&] {
+        for (int a = 0; a <= k; ++a) {
+            w[a] = f.one();
+            for (int b = 0; b <= k; ++b)
+                if (b != a) w[a] = f.mul(w[a], f.sub(fx[win[a]], fx[win[b]]));
+        }
+        if (!batch_invert(f, w)) return false;
+        E s = f.zero();
+        for (int a = 0; a <= k; ++a) s = f.add(s, f.mul(fy[win[a]], w[a]));
+        return f.is_zero(s);
+    };
+    int m = (int)ok.size(), slides = m - k, samples = 32 * m;
+    mt19937_64 rng(0x5eed ^ ((uint64_t)m << 32 | (uint64_t)k));
+    bool found = false;
+    for (int t = 0; t < slides + samples && !found; ++t) {
+        if (t < slides) {
+            for (int a = 0; a <= k; ++a) win[a] = ok[t + a];
+        } else { // Floyd's sample of k + 1 distinct positions in ok
+            vector<int> pos;
+            for (int j = m - k - 1; j < m; ++j) {
+                int r = (int)(rng() % (uint64_t)(j + 1));
+                pos.push_back(find(pos.begin(), pos.end(), r) == pos.end() ? r : j);
+            }
+            sort(pos.begin(), pos.end());
+            for (int a = 0; a <= k; ++a) win[a] = ok[pos[a]];
+        }
+        found = consistent();
+    }
+    if (!found) return false;
+
+    vector<E> px(k), py(k), poly;
+    for (int a = 0; a < k; ++a) {
+        px[a] = fx[win[a]];
+        py[a] = fy[win[a]];
+    }
+    if (!interpolate_coeffs_modp(f, px, py, poly)) return false;
+    keep.clear();
+    for (int i : ok)
+        if (f.is_zero(f.sub(poly_eval(f, poly, fx[i]), fy[i]))) keep.push_back(i);
+    return (int)keep.size() > k;
+}
+
+// ---------- Solver API ----------
+// Decoded shares of one object, ready for a search.
+struct ShareSet {
+    int k = 0;
+    cpp_int prime = 0; // nonzero: reconstruct in GF(prime)
+    vector<int> xs;
+    vector<cpp_int> ys;
+};
+
+// bad is only filled in decode mode.
+inline bool search_shares(const ShareSet &set, cpp_int &constant, vector<int> &bad, const SolveOptions &opt,
+                          SearchScratch *scratch = nullptr) {
+    if (!scratch) {
+        SearchScratch local;
+        return search_shares(set, constant, bad, opt, &local);
+    }
+    const vector<int> &xs = set.xs;
+    const vector<cpp_int> &ys = set.ys;
+    if (opt.decode)
+        return set.prime != 0 ? decode_shares_modp(set.prime, xs, ys, set.k, constant, bad)
+                              : decode_shares_integer(xs, ys, set.k, constant, bad, opt);
+    if (set.prime != 0) return find_valid_constant_modp(set.prime, xs, ys, set.k, constant, opt.budget);
+    vector<int> keep;
+    if (opt.prune && consistent_shares(xs, ys, set.k, keep)) {
+        vector<int> idx(keep.begin(), keep.begin() + set.k);
+        SubsetSolver &solver = scratch->solver;
+        solver.reset(xs, ys, opt);
+        stat_combo_tried();
+        if ((!opt.budget || opt.budget->charge()) && solver.accept(idx)) {
+            constant = solver.coeffs()[0].num;
+            return true;
+        }
+    }
+    if (opt.search == Search::Revolving) return find_valid_constant_revolving(xs, ys, set.k, constant, opt, *scratch);
+    if (opt.threads > 1) return find_valid_constant_parallel(xs, ys, set.k, constant, opt, *scratch);
+    return find_valid_constant(xs, ys, set.k, constant, opt, *scratch);
+}
+
+inline string format_result(const cpp_int &constant, const vector<int> &bad, const SolveOptions &opt) {
+    string out = cpp_int_to_string(constant, opt.out_base);
+    if (!opt.decode) return out;
+    out += " bad=";
+    for (size_t i = 0; i < bad.size(); ++i) out += (i ? "," : "") + to_string(bad[i]);
+    return out;
+}
+
+struct SolveResult {
+    enum class Status { Ok, Failed, Timeout };
+    Status status = Status::Failed;
+    cpp_int constant;
+    vector<int> bad; // x values of the bad shares, decode mode only
+    // Timeout only: subsets charged, C(n, k) saturated at UINT64_MAX, wall time.
+    uint64_t tried = 0, total = 0, elapsed_ms = 0;
+
+    bool ok() const { return status == Status::Ok; }
+};
+
+// What the command line prints for a result: the constant (plus " bad=..."
+// when decoding), a TIMEOUT status line, or "" for a plain failure.
+inline string format_status(const SolveResult &r, const SolveOptions &opt) {
+    if (r.status == SolveResult::Status::Ok) return format_result(r.constant, r.bad, opt);
+    if (r.status == SolveResult::Status::Failed) return "";
+    string out = "TIMEOUT tried=" + to_string(r.tried) + "/";
+    out += r.total == UINT64_MAX ? ">" + to_string(UINT64_MAX) : to_string(r.total);
+    return out + " elapsed_ms=" + to_string(r.elapsed_ms);
+}
+
+// ---------- Result cache ----------
+// Bounded LRU from a share set to its search result, shared by all threads, so a
+// repeated object costs one key build and one lookup. The key is the exact share
+// set (k, prime, then every share's x and y in x order) plus the options that can
+// change the answer (search order, decode, prune, consensus); it is compared in full,
+// so crafted inputs cannot collide into someone else's result. Nothing from a
+// search whose budget ran out is stored, not even an answer: limits and threads
+// are not in the key, and such a search may stop short of the canonical subset.
+// Capacity 0 (the default) disables it. Like the weight cache it can be saved to
+// and loaded from a text file.
+struct CachedResult {
+    bool ok = false;
+    cpp_int constant;
+    vector<int> bad;
+};
+
+inline void append_key_word(string &key, uint64_t w) {
+    for (int i = 0; i < 8; ++i, w >>= 8) key.push_back((char)(w & 0xff));
+}
+
+inline void append_key_int(string &key, const cpp_int &v) {
+    size_t limbs = v == 0 ? 0 : (size_t)msb(abs(v)) / 64 + 1;
+    append_key_word(key, limbs << 1 | (v < 0));
+    for (size_t i = 0; i < limbs; ++i) append_key_word(key, (uint64_t)(abs(v) >> (64 * i)));
+}
+
+inline void result_cache_key(const ShareSet &set, const SolveOptions &opt, string &key) {
+    key.clear();
+    append_key_word(key, (uint64_t)set.k);
+    append_key_word(key, (uint64_t)opt.search | (uint64_t)opt.decode << 8 | (uint64_t)opt.prune << 9 |
+                             (uint64_t)(uint32_t)opt.consensus << 16);
+    append_key_int(key, set.prime);
+    append_key_word(key, set.xs.size());
+    for (size_t i = 0; i < set.xs.size(); ++i) {
+        append_key_word(key, (uint32_t)set.xs[i]);
+        append_key_int(key, set.ys[i]);
+    }
+}
+
+class ResultCache {
+public:
+    static ResultCache &global() {
+        static ResultCache cache;
+        return cache;
+    }
+
+    void set_capacity(size_t cap) {
+        lock_guard<mutex> lock(mu_);
+        cap_ = cap;
+        evict();
+    }
+    size_t capacity() const {
+        lock_guard<mutex> lock(mu_);
+        return cap_;
+    }
+
+    bool get(const string &key, CachedResult &out) {
+        lock_guard<mutex> lock(mu_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        out = it->second->result;
+        return true;
+    }
+
+    void put(const string &key, const CachedResult &r) {
+        lock_guard<mutex> lock(mu_);
+        if (cap_ == 0 || index_.count(key)) return;
+        lru_.push_front(Entry{key, r});
+        index_.emplace(lru_.front().key, lru_.begin());
+        bytes_ += footprint(lru_.front());
+        evict();
+    }
+
+    // Format: one entry per line, "hexkey ok constant bad_1 .. bad_m sum", most
+    // recently used first, where sum is the hex line_hash of the line before
+    // it. A missing file is not an error. Lines that are corrupted or fail
+    // their checksum are dropped and the rest loaded; false reports a drop.
+    bool load(const string &path) {
+        ifstream in(path);
+        if (!in) return true;
+        string line, hex;
+        vector<Entry> entries;
+        bool intact = true;
+        while (getline(in, line)) {
+            if (line.empty()) continue;
+            string_view body;
+            Entry e;
+            if (!checked_line(line, body) || !parse_entry(body, hex, e)) {
+                intact = false;
+                continue;
+            }
+            entries.push_back(move(e));
+        }
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) put(it->key, it->result);
+        return intact;
+    }
+
+    bool save(const string &path) const {
+        ofstream out(path, ios::trunc);
+        if (!out) return false;
+        lock_guard<mutex> lock(mu_);
+        string hex;
+        for (const Entry &e : lru_) {
+            hex.clear();
+            for (unsigned char c : e.key) {
+                hex.push_back("0123456789abcdef"[c >> 4]);
+                hex.push_back("0123456789abcdef"[c & 15]);
+            }
+            ostringstream line;
+            line << hex << ' ' << e.result.ok << ' ' << e.result.constant;
+            for (int x : e.result.bad) line << ' ' << x;
+            string body = line.str();
+            out << body << ' ' << std::hex << line_hash(body) << std::dec << '\n';
+        }
+        return bool(out);
+    }
+
+private:
+    struct Entry {
+        string key;
+        CachedResult result;
+    };
+    using List = list<Entry>;
+
+    static bool parse_entry(string_view body, string &hex, Entry &e) {
+        istringstream ls{string(body)};
+        if (!(ls >> hex >> e.result.ok >> e.result.constant) || hex.size() % 2 != 0) return false;
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            int hi = hex_value(hex[i]), lo = hex_value(hex[i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            e.key.push_back((char)(hi << 4 | lo));
+        }
+        for (int x; ls >> x;) e.result.bad.push_back(x);
+        return ls.eof();
+    }
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+    static size_t footprint(const Entry &e) {
+        return sizeof(Entry) + e.key.size() + e.result.bad.size() * sizeof(int) +
+               (e.result.constant == 0 ? 0 : msb(abs(e.result.constant)) / 8);
+    }
+    void evict() {
+        while (!lru_.empty() && (lru_.size() > cap_ || bytes_ > kMaxBytes)) {
+            bytes_ -= footprint(lru_.back());
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    static constexpr size_t kMaxBytes = size_t(256) << 20;
+
+    mutable mutex mu_;
+    size_t cap_ = 0, bytes_ = 0;
+    List lru_;
+    unordered_map<string_view, List::iterator> index_; // views into the list's keys
+};
+
+// ---------- Solver context ----------
+// Reusable solver context for embedding: keep one per thread and call solve()
+// per share set. The result is owned by the solver and overwritten by the next
+// call, so its vectors keep their capacity. The search tables (SearchScratch)
+// are members too and are reset per call, and the elimination engines work in
+// this thread's limb arena, which stays allocated between calls, so a warm
+// solver allocates next to nothing on small share sets. Share sets are not
+// validated: subsets that repeat an x are skipped, so duplicates only matter
+// when no subset of distinct x is valid, and every outcome is reported in
+// SolveResult::status rather than thrown (malformed input is the parser's
+// concern). With the ResultCache enabled a repeated share set skips the search.
+class ShamirSolver {
+public:
+    explicit ShamirSolver(const SolveOptions &opt = SolveOptions()) : opt_(opt) {}
+
+    SolveOptions &options() { return opt_; }
+    const SolveOptions &options() const { return opt_; }
+
+    const SolveResult &solve(const ShareSet &set) {
+        SearchBudget budget(opt_.time_limit_ms, opt_.max_combos);
+        SolveOptions local = opt_;
+        local.budget = opt_.time_limit_ms > 0 || opt_.max_combos > 0 ? &budget : nullptr;
+        local.cache_weights =
+            LagrangeWeightCache::global().worth_caching(binom_saturated((int)set.xs.size(), set.k));
+        SolveResult &r = result_;
+        r.status = SolveResult::Status::Failed;
+        r.bad.clear();
+        r.tried = r.total = r.elapsed_ms = 0;
+        StatTimer timer(&StatCounters::search_ns);
+        ResultCache &cache = ResultCache::global();
+        bool cached = cache.capacity() > 0;
+        if (cached) {
+            result_cache_key(set, opt_, key_);
+            if (cache.get(key_, hit_)) {
+                if (g_stats_enabled) ++StatCounters::local().result_hits;
+                r.status = hit_.ok ? SolveResult::Status::Ok : SolveResult::Status::Failed;
+                r.constant = hit_.constant;
+                r.bad = hit_.bad;
+                return r;
+            }
+        }
+        bool ok = search_shares(set, r.constant, r.bad, local, &scratch_);
+        if (cached && !budget.exhausted()) {
+            hit_.ok = ok;
+            hit_.constant = ok ? r.constant : cpp_int(0);
+            hit_.bad = r.bad;
+            cache.put(key_, hit_);
+        }
+        if (ok) {
+            r.status = SolveResult::Status::Ok;
+        } else if (budget.exhausted()) {
+            r.status = SolveResult::Status::Timeout;
+            r.tried = budget.tried();
+            r.total = binom_saturated((int)set.xs.size(), set.k);
+            r.elapsed_ms = (uint64_t)budget.elapsed_ms();
+        }
+        return r;
+    }
+
+private:
+    SolveOptions opt_;
+    SolveResult result_;
+    SearchScratch scratch_;
+    string key_; // result cache scratch
+    CachedResult hit_;
+};
+
+} // namespace shamir
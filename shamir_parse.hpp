@@ -0,0 +1,570 @@
+// shamir_parse.hpp
+// Header-only input front end: JSON object tokenizer, input splitting,
+// memory-mapped and streaming readers, the binary share format, and
+// ShareParser, which turns one object or record into the ShareSet that
+// ShamirSolver consumes.
+#pragma once
+
+#include "shamir_core.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shamir {
+
+// ---------- Single-pass object tokenizer ----------
+// One linear scan over an object collects "keys" and a flat table of shares.
+// Every member is matched in its own scope, so a "base" value that happens to
+// spell a share index can no longer be mistaken for that share, and shares are
+// taken from whatever indices actually appear (not just 1..n). Spans point into
+// the object text; strings are not unescaped, which the share format never needs.
+struct ShareSpan {
+    int x;
+    string_view base, value;
+};
+
+struct ParsedObject {
+    bool has_keys = false, has_n = false, has_k = false, has_prime = false;
+    long long n = 0, k = 0;
+    string_view prime;
+    vector<ShareSpan> shares; // sorted by x
+};
+
+class JsonCursor {
+public:
+    explicit JsonCursor(string_view s) : s_(s) {}
+
+    void expect(char c) {
+        ws();
+        if (i_ >= s_.size() || s_[i_] != c) throw runtime_error(string("invalid json: expected ") + c);
+        ++i_;
+    }
+    bool peek(char c) {
+        ws();
+        return i_ < s_.size() && s_[i_] == c;
+    }
+    string_view string_token() {
+        expect('"');
+        size_t a = i_;
+        while (i_ < s_.size() && s_[i_] != '"') i_ += s_[i_] == '\\' ? 2 : 1;
+        if (i_ >= s_.size()) throw runtime_error("invalid json: missing closing quote");
+        return s_.substr(a, i_++ - a);
+    }
+    // a number/true/false/null token, or the contents of a string
+    string_view scalar() {
+        if (peek('"')) return string_token();
+        size_t a = i_;
+        while (i_ < s_.size() && !isspace((unsigned char)s_[i_]) && s_[i_] != ',' && s_[i_] != '}' && s_[i_] != ']')
+            ++i_;
+        if (a == i_) throw runtime_error("invalid json: missing value");
+        return s_.substr(a, i_ - a);
+    }
+    void skip_value() {
+        if (peek('{') || peek('[')) {
+            char close = s_[i_] == '{' ? '}' : ']';
+            ++i_;
+            if (peek(close)) { ++i_; return; }
+            do {
+                if (close == '}') { string_token(); expect(':'); }
+                skip_value();
+            } while (comma());
+            expect(close);
+            return;
+        }
+        scalar();
+    }
+    // consumes a separating comma if there is one
+    bool comma() {
+        if (!peek(',')) return false;
+        ++i_;
+        return true;
+    }
+
+private:
+    void ws() { while (i_ < s_.size() && isspace((unsigned char)s_[i_])) ++i_; }
+    string_view s_;
+    size_t i_ = 0;
+};
+
+inline bool all_digits(string_view s) {
+    if (s.empty()) return false;
+    for (char c : s) if (!isdigit((unsigned char)c)) return false;
+    return true;
+}
+
+// Calls member(key) for each member of the object at the cursor; the callback consumes the value.
+template <class Fn>
+inline void for_each_member(JsonCursor &cur, Fn &&member) {
+    cur.expect('{');
+    if (cur.peek('}')) { cur.expect('}'); return; }
+    do {
+        string_view key = cur.string_token();
+        cur.expect(':');
+        member(key);
+    } while (cur.comma());
+    cur.expect('}');
+}
+
+inline void reset_object(ParsedObject &out) {
+    out.has_keys = out.has_n = out.has_k = out.has_prime = false;
+    out.n = out.k = 0;
+    out.prime = {};
+    out.shares.clear();
+}
+
+// The "keys" object at the cursor.
+inline void parse_keys_member(JsonCursor &cur, ParsedObject &out) {
+    out.has_keys = true;
+    for_each_member(cur, [&](string_view k) {
+        if (k == "n") { out.n = stoll(string(cur.scalar())); out.has_n = true; }
+        else if (k == "k") { out.k = stoll(string(cur.scalar())); out.has_k = true; }
+        else if (k == "prime") { out.prime = cur.scalar(); out.has_prime = true; }
+        else cur.skip_value();
+    });
+}
+
+// Only the top-level "keys" member: the scan stops right after it and skips
+// the members before it without reading shares. Throws on malformed JSON;
+// returns out.has_keys.
+inline bool parse_keys(string_view text, ParsedObject &out) {
+    reset_object(out);
+    JsonCursor cur(text);
+    cur.expect('{');
+    if (cur.peek('}')) return false;
+    do {
+        string_view key = cur.string_token();
+        cur.expect(':');
+        if (key == "keys" && cur.peek('{')) {
+            parse_keys_member(cur, out);
+            return true;
+        }
+        cur.skip_value();
+    } while (cur.comma());
+    return false;
+}
+
+// Throws on malformed JSON; returns false when a share lacks "base" or "value".
+// out is reset first; its share vector keeps its capacity.
+inline bool parse_object(string_view text, ParsedObject &out) {
+    reset_object(out);
+    JsonCursor cur(text);
+    bool complete = true;
+    for_each_member(cur, [&](string_view key) {
+        if (key == "keys" && cur.peek('{')) {
+            parse_keys_member(cur, out);
+        } else if (all_digits(key) && cur.peek('{')) {
+            long long x = stoll(string(key));
+            if (x > INT_MAX) throw runtime_error("share index out of range");
+            ShareSpan share{(int)x, {}, {}};
+            bool has_base = false, has_value = false;
+            for_each_member(cur, [&](string_view k) {
+                if (k == "base") { share.base = cur.scalar(); has_base = true; }
+                else if (k == "value") { share.value = cur.scalar(); has_value = true; }
+                else cur.skip_value();
+            });
+            if (!has_base || !has_value) complete = false;
+            out.shares.push_back(share);
+        } else {
+            cur.skip_value();
+        }
+    });
+    stable_sort(out.shares.begin(), out.shares.end(), [](const ShareSpan &a, const ShareSpan &b) { return a.x < b.x; });
+    return complete;
+}
+
+// ---------- Extract JSON objects from input string ----------
+// Top-level brace tracking shared by the whole-input splitter and the streaming
+// reader, so both cut the input at exactly the same places.
+struct BraceScanner {
+    int depth = 0;
+    bool open = false;
+    enum Event { None, Start, End };
+    Event feed(char c) {
+        if (c == '{') {
+            Event e = depth == 0 ? Start : None;
+            if (e == Start) open = true;
+            depth++;
+            return e;
+        }
+        if (c == '}') {
+            depth--;
+            if (depth == 0 && open) {
+                open = false;
+                return End;
+            }
+        }
+        return None;
+    }
+};
+
+// Views into input; they live as long as the input does.
+inline vector<string_view> split_json_objects(string_view input) {
+    vector<string_view> objs;
+    BraceScanner scan;
+    size_t start = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+        BraceScanner::Event e = scan.feed(input[i]);
+        if (e == BraceScanner::Start) start = i;
+        else if (e == BraceScanner::End) objs.push_back(input.substr(start, i - start + 1));
+    }
+    return objs;
+}
+
+// ---------- Memory-mapped input ----------
+// Maps a whole file read-only so objects can be solved straight out of the page
+// cache; nothing is read until a page is first touched.
+class MappedFile {
+public:
+    explicit MappedFile(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("cannot stat " + path);
+        }
+        size_ = (size_t)st.st_size;
+        if (size_ > 0) {
+            void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("cannot map " + path);
+            }
+            data_ = (const char *)p;
+            madvise(p, size_, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+    ~MappedFile() {
+        if (data_) munmap((void *)data_, size_);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    string_view view() const { return string_view(data_, size_); }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// ---------- Decode one object ----------
+inline bool decode_object(const ParsedObject &obj, ShareSet &set) {
+    if (!obj.has_keys || !obj.has_n || !obj.has_k) return false;
+    long long n = obj.n, k = obj.k;
+    if (n <= 0 || k <= 0) return false;
+
+    // optional "prime" inside "keys" switches the object to GF(p) reconstruction
+    set.prime = 0;
+    if (obj.has_prime) {
+        set.prime = parse_in_base_cpp(obj.prime, 10);
+        if (set.prime == 0) return false;
+    }
+
+    set.xs.clear();
+    set.ys.clear();
+    set.xs.reserve(obj.shares.size()); set.ys.reserve(obj.shares.size());
+    for (const ShareSpan &share : obj.shares) {
+        int base = stoi(string(share.base));
+        set.xs.push_back(share.x);
+        set.ys.push_back(parse_in_base_cpp(share.value, base));
+    }
+    if ((long long)set.xs.size() < k) return false;
+    set.k = (int)k;
+    return true;
+}
+
+// ---------- Binary share records ----------
+// A binary share file is the magic "SHMIRB01" followed by records. Fields are
+// little-endian and every record is a multiple of 8 bytes long, so in a mapped
+// file each y is an aligned run of 64-bit limbs that is copied into a cpp_int
+// as is, with no digit decoding:
+//   "SHR1", u32 n, u32 k, u32 shares, u64 record bytes, u32 prime limbs, u32 0
+//   u64 prime[prime limbs]                      (none: reconstruct over Q)
+//   per share: i32 x, u32 limbs | sign << 31, u64 y[limbs]
+// Shares are stored sorted by x. The converter writes k = 0 for an object it
+// could not decode, which solves to ERROR like the JSON original.
+constexpr char kBinaryMagic[8] = {'S', 'H', 'M', 'I', 'R', 'B', '0', '1'};
+constexpr char kRecordTag[4] = {'S', 'H', 'R', '1'};
+constexpr size_t kRecordHeaderBytes = 32;
+// Longest record accepted, so a claimed length never makes a reader buffer
+// without bound; the converter writes the placeholder for a longer object.
+constexpr uint64_t kMaxRecordBytes = uint64_t(64) << 20;
+
+inline uint64_t load_le(const char *p, int bytes) {
+    uint64_t v = 0;
+    for (int i = bytes; i-- > 0;) v = v << 8 | (unsigned char)p[i];
+    return v;
+}
+
+inline void store_le(string &out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i, v >>= 8) out.push_back((char)(v & 0xff));
+}
+
+inline bool is_binary_shares(string_view input) {
+    return input.size() >= sizeof(kBinaryMagic) && memcmp(input.data(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+}
+
+inline bool is_binary_record(string_view rec) {
+    return rec.size() >= kRecordHeaderBytes && memcmp(rec.data(), kRecordTag, sizeof(kRecordTag)) == 0;
+}
+
+// Whether a header's record byte count describes a record a reader may take.
+inline bool record_bytes_ok(uint64_t bytes) {
+    return bytes >= kRecordHeaderBytes && bytes % 8 == 0 && bytes <= kMaxRecordBytes;
+}
+
+// Record views of a binary share file. A truncated or corrupt tail comes back
+// as one last view that fails to decode, so it still prints ERROR.
+inline vector<string_view> split_binary_records(string_view input) {
+    vector<string_view> out;
+    size_t pos = sizeof(kBinaryMagic);
+    while (pos < input.size()) {
+        string_view rest = input.substr(pos);
+        uint64_t bytes = is_binary_record(rest) ? load_le(rest.data() + 16, 8) : 0;
+        if (!record_bytes_ok(bytes) || bytes > rest.size()) {
+            out.push_back(rest);
+            break;
+        }
+        out.push_back(rest.substr(0, bytes));
+        pos += bytes;
+    }
+    return out;
+}
+
+// JSON objects or, for a binary share file, its records.
+inline vector<string_view> split_input(string_view input) {
+    return is_binary_shares(input) ? split_binary_records(input) : split_json_objects(input);
+}
+
+// v = the limbs at p (least significant first), negated if neg.
+inline void load_limbs(const char *p, size_t limbs, bool neg, cpp_int &v) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (sizeof(boost::multiprecision::limb_type) == 8) {
+        v.backend().resize(limbs ? limbs : 1, limbs ? limbs : 1);
+        if (limbs) memcpy(v.backend().limbs(), p, 8 * limbs);
+        else v.backend().limbs()[0] = 0;
+        v.backend().normalize();
+        if (neg) v.backend().negate();
+        return;
+    }
+#endif
+    v = 0;
+    if (limbs) import_bits(v, (const unsigned char *)p, (const unsigned char *)p + 8 * limbs, 8, false);
+    if (neg) v = -v;
+}
+
+inline size_t limb_count(const cpp_int &v) { return v == 0 ? 0 : (size_t)msb(abs(v)) / 64 + 1; }
+
+// Appends |v| as limb_count(v) little-endian 64-bit limbs.
+inline void append_limbs(string &out, const cpp_int &v) {
+    size_t limbs = limb_count(v);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (sizeof(boost::multiprecision::limb_type) == 8) {
+        out.append((const char *)v.backend().limbs(), 8 * limbs);
+        return;
+    }
+#endif
+    vector<unsigned char> bytes; // least significant first
+    if (limbs) export_bits(cpp_int(abs(v)), back_inserter(bytes), 8, false);
+    bytes.resize(8 * limbs, 0);
+    out.append(bytes.begin(), bytes.end());
+}
+
+// Decodes one record into set, reusing the limbs already held by set.ys.
+inline bool decode_record(string_view rec, ShareSet &set) {
+    if (!is_binary_record(rec) || load_le(rec.data() + 16, 8) != rec.size() || !record_bytes_ok(rec.size())) return false;
+    const char *p = rec.data();
+    uint64_t n = load_le(p + 4, 4), k = load_le(p + 8, 4), shares = load_le(p + 12, 4);
+    uint64_t prime_limbs = load_le(p + 24, 4);
+    if (n == 0 || k == 0 || k > INT_MAX) return false;
+    size_t pos = kRecordHeaderBytes;
+    auto fits = [&](uint64_t bytes) { return bytes <= rec.size() - pos; };
+    if (!fits(8 * prime_limbs)) return false;
+    load_limbs(p + pos, prime_limbs, false, set.prime);
+    pos += 8 * prime_limbs;
+    if (prime_limbs && set.prime == 0) return false;
+    // Every share takes at least its 8 bytes of x and limb count, so an
+    // untrusted count never sizes the vectors beyond what the record holds.
+    if (shares > (rec.size() - pos) / 8) return false;
+
+    set.xs.resize(shares);
+    set.ys.resize(shares);
+    for (uint64_t i = 0; i < shares; ++i) {
+        if (!fits(8)) return false;
+        uint32_t word = (uint32_t)load_le(p + pos + 4, 4), limbs = word & 0x7fffffffu;
+        set.xs[i] = (int32_t)(uint32_t)load_le(p + pos, 4);
+        pos += 8;
+        if (!fits(8ull * limbs)) return false;
+        load_limbs(p + pos, limbs, word >> 31, set.ys[i]);
+        pos += 8ull * limbs;
+    }
+    if (!is_sorted(set.xs.begin(), set.xs.end())) { // same order as the JSON reader
+        vector<int> order(shares);
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return set.xs[a] < set.xs[b]; });
+        vector<int> xs(shares);
+        vector<cpp_int> ys(shares);
+        for (uint64_t i = 0; i < shares; ++i) {
+            xs[i] = set.xs[order[i]];
+            ys[i].swap(set.ys[order[i]]);
+        }
+        set.xs.swap(xs);
+        set.ys.swap(ys);
+    }
+    if (shares < k) return false;
+    set.k = (int)k;
+    return true;
+}
+
+// Appends the record for one object; ok = false writes the k = 0 placeholder.
+inline void append_record(string &out, const ParsedObject &obj, const ShareSet &set, bool ok) {
+    size_t start = out.size();
+    out.append(kRecordTag, sizeof(kRecordTag));
+    store_le(out, ok ? (uint64_t)obj.n : 0, 4);
+    store_le(out, ok ? (uint64_t)set.k : 0, 4);
+    store_le(out, ok ? set.xs.size() : 0, 4);
+    store_le(out, 0, 8); // record bytes, patched below
+    store_le(out, ok ? limb_count(set.prime) : 0, 4);
+    store_le(out, 0, 4);
+    if (ok) {
+        append_limbs(out, set.prime);
+        for (size_t i = 0; i < set.xs.size(); ++i) {
+            store_le(out, (uint32_t)set.xs[i], 4);
+            store_le(out, limb_count(set.ys[i]) | (set.ys[i] < 0 ? 1ull << 31 : 0), 4);
+            append_limbs(out, set.ys[i]);
+        }
+    }
+    uint64_t bytes = out.size() - start;
+    if (bytes > kMaxRecordBytes) {
+        out.resize(start);
+        append_record(out, obj, set, false);
+        return;
+    }
+    for (int i = 0; i < 8; ++i) out[start + 16 + i] = (char)(bytes >> (8 * i) & 0xff);
+}
+
+// Converts JSON objects to a binary share file, one record per object in order.
+inline string json_to_binary(string_view input) {
+    string out(kBinaryMagic, sizeof(kBinaryMagic));
+    ParsedObject obj;
+    ShareSet set;
+    for (string_view text : split_json_objects(input)) {
+        bool ok = false;
+        try {
+            ok = parse_object(text, obj) && decode_object(obj, set) && obj.n <= UINT32_MAX;
+        } catch (const exception &) {
+        }
+        append_record(out, obj, set, ok);
+    }
+    return out;
+}
+
+// ---------- Streaming object reader ----------
+// Reads the input in chunks and yields each top-level JSON object as soon as
+// its closing brace arrives, or, when the stream opens with the binary magic,
+// each record as soon as its last byte arrives. Objects are views into one
+// reusable buffer that only ever holds the unfinished tail, so memory stays at
+// about one chunk plus the largest object no matter how long the stream is.
+// The source returns the bytes it read, 0 at end of input; it may return short
+// counts, which is what lets sockets hand over requests one at a time.
+class ObjectStream {
+public:
+    using Source = function<size_t(char *, size_t)>;
+
+    explicit ObjectStream(istream &in, size_t chunk = 1 << 20)
+        : ObjectStream([&in](char *p, size_t n) { in.read(p, (streamsize)n); return (size_t)in.gcount(); }, chunk) {}
+    explicit ObjectStream(Source source, size_t chunk = 1 << 20) : source_(move(source)), chunk_(chunk) {}
+
+    // The view stays valid until the next call.
+    bool next(string_view &obj) {
+        while (mode_ != Mode::Done) {
+            if (mode_ == Mode::Unknown && (buf_.size() >= sizeof(kBinaryMagic) || eof_ ||
+                                           (!buf_.empty() && buf_[0] != kBinaryMagic[0]))) {
+                mode_ = is_binary_shares(buf_) ? Mode::Binary : Mode::Json;
+                if (mode_ == Mode::Binary) scan_ = start_ = sizeof(kBinaryMagic);
+            }
+            if (mode_ == Mode::Json) {
+                for (; scan_ < buf_.size(); ++scan_) {
+                    BraceScanner::Event e = brace_.feed(buf_[scan_]);
+                    if (e == BraceScanner::Start) {
+                        start_ = scan_;
+                    } else if (e == BraceScanner::End) {
+                        obj = string_view(buf_.data() + start_, scan_ - start_ + 1);
+                        ++scan_;
+                        start_ = string::npos;
+                        return true;
+                    }
+                }
+            } else if (mode_ == Mode::Binary && start_ < buf_.size()) {
+                string_view rest(buf_.data() + start_, buf_.size() - start_);
+                uint64_t bytes = rest.size() >= kRecordHeaderBytes ? load_le(rest.data() + 16, 8) : 0;
+                // checked on the header alone, before any of the record is buffered
+                bool bad = rest.size() >= kRecordHeaderBytes && (!is_binary_record(rest) || !record_bytes_ok(bytes));
+                // an unusable tail comes back as one last view that fails to decode
+                if (bad || (eof_ && (bytes == 0 || bytes > rest.size()))) {
+                    obj = rest;
+                    start_ = scan_ = buf_.size();
+                    mode_ = Mode::Done;
+                    return true;
+                }
+                if (bytes && bytes <= rest.size()) {
+                    obj = rest.substr(0, bytes);
+                    start_ = scan_ = start_ + bytes;
+                    return true;
+                }
+            }
+            if (eof_) return false;
+            // keep only the object in progress, then pull the next chunk
+            size_t keep = mode_ == Mode::Json ? (brace_.open ? start_ : buf_.size())
+                          : mode_ == Mode::Binary ? start_ : 0;
+            buf_.erase(0, keep);
+            scan_ -= keep;
+            if (start_ != string::npos) start_ -= keep;
+            size_t old = buf_.size();
+            buf_.resize(old + chunk_);
+            size_t got = source_(&buf_[old], chunk_);
+            buf_.resize(old + got);
+            bytes_ += got;
+            eof_ = got == 0;
+        }
+        return false;
+    }
+
+    size_t bytes_read() const { return bytes_; }
+
+private:
+    enum class Mode { Unknown, Json, Binary, Done };
+
+    Source source_;
+    size_t chunk_;
+    string buf_;
+    size_t scan_ = 0, start_ = string::npos, bytes_ = 0;
+    bool eof_ = false;
+    Mode mode_ = Mode::Unknown;
+    BraceScanner brace_;
+};
+
+// Front end for ShamirSolver: turns one JSON object or binary record into a
+// ShareSet, reusing the token spans and share vectors of the previous call.
+class ShareParser {
+public:
+    bool parse(string_view text, ShareSet &set) {
+        if (is_binary_record(text)) {
+            StatTimer timer(&StatCounters::decode_ns);
+            return decode_record(text, set);
+        }
+        {
+            StatTimer timer(&StatCounters::parse_ns);
+            if (!parse_object(text, obj_)) return false;
+        }
+        StatTimer timer(&StatCounters::decode_ns);
+        return decode_object(obj_, set);
+    }
+
+private:
+    ParsedObject obj_;
+};
+
+} // namespace shamir
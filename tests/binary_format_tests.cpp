@@ -0,0 +1,126 @@
+// binary_format_tests.cpp
+// The binary share format (json_to_binary, split_binary_records, decode_record):
+//   binary_roundtrip PATH   every object of PATH (plus GF(p) and multi-limb values)
+//                           decodes to the same ShareSet and result from JSON and binary
+//   binary_rejects_bad      truncated records and oversized share counts fail to decode
+//   stream_records          ObjectStream yields the records of a stream read a few bytes
+//                           at a time, and rejects a record over kMaxRecordBytes from its header
+
+#include "shamir_tests.hpp"
+
+// Objects the sample file lacks: a prime field, multi-limb values and a zero.
+static const char *kExtraObjects = R"([
+  {"keys": {"n": 3, "k": 2, "prime": "340282366920938463463374607431768211297"},
+   "1": {"base": "10", "value": "340282366920938463463374607431768211000"},
+   "2": {"base": "16", "value": "ff"},
+   "4": {"base": "10", "value": "12345"}},
+  {"keys": {"n": 3, "k": 2},
+   "2": {"base": "10", "value": "7"},
+   "3": {"base": "10", "value": "1000000000000000000000000000000000000000000000007"},
+   "5": {"base": "10", "value": "0"}}
+])";
+
+// ---------- binary_roundtrip ----------
+static void test_binary_roundtrip(const vector<string> &args) {
+    string input = read_file(args.at(0)) + kExtraObjects;
+    vector<string_view> objs = split_json_objects(input);
+    string bin = json_to_binary(input);
+    check(is_binary_shares(bin), "json_to_binary writes the file magic");
+    vector<string_view> recs = split_binary_records(bin);
+    check(recs.size() == objs.size(), "one record per JSON object");
+
+    ShareParser parser;
+    ShamirSolver solver;
+    for (size_t i = 0; i < min(objs.size(), recs.size()); ++i) {
+        string tag = "object " + to_string(i) + ": ";
+        ShareSet a, b;
+        bool ok_json = false;
+        try {
+            ok_json = parser.parse(objs[i], a);
+        } catch (const exception &) {
+        }
+        bool ok_bin = decode_record(recs[i], b);
+        check(ok_json == ok_bin, tag + "JSON and binary agree on validity");
+        if (!ok_json || !ok_bin) continue;
+        check(a.k == b.k && a.prime == b.prime, tag + "k and prime survive");
+        check(a.xs == b.xs && a.ys == b.ys, tag + "shares survive");
+        string ra = solve_text(solver, a), rb = solve_text(solver, b);
+        check(ra == rb, tag + "same result (" + ra + " vs " + rb + ")");
+    }
+}
+
+// ---------- binary_rejects_bad ----------
+static void test_binary_rejects_bad(const vector<string> &) {
+    string bin = json_to_binary(kExtraObjects);
+    vector<string_view> recs = split_binary_records(bin);
+    check(recs.size() == 2, "two records");
+    if (recs.size() != 2) return;
+    string rec(recs[1]);
+    ShareSet set;
+    check(decode_record(rec, set), "intact record decodes");
+
+    for (size_t len = 0; len < rec.size(); ++len)
+        check(!decode_record(string_view(rec).substr(0, len), set), "truncated record of " + to_string(len) + " bytes");
+
+    // A truncated file still yields a last view, which must fail.
+    string cut = bin.substr(0, bin.size() - 3);
+    vector<string_view> tail = split_binary_records(cut);
+    check(tail.size() == 2 && !decode_record(tail.back(), set), "truncated file ends in a failing record");
+
+    // Share counts the record cannot hold are rejected before anything is sized.
+    for (uint32_t shares : {4u, 40000000u, 0xffffffffu}) {
+        string bad = rec;
+        memcpy(&bad[12], &shares, 4);
+        ShareSet fresh;
+        check(!decode_record(bad, fresh), "share count " + to_string(shares));
+        check(fresh.xs.capacity() < 1024, "share count " + to_string(shares) + " allocates nothing");
+    }
+
+    // A byte count that disagrees with the record's size.
+    string longer = rec;
+    uint64_t bytes = rec.size() + 8;
+    memcpy(&longer[16], &bytes, 8);
+    check(!decode_record(longer, set), "record byte count mismatch");
+}
+
+// ---------- stream_records ----------
+static void test_stream_records(const vector<string> &) {
+    string bin = json_to_binary(kExtraObjects);
+    size_t pos = 0;
+    ObjectStream stream(
+        [&](char *p, size_t n) {
+            n = min({n, (size_t)5, bin.size() - pos});
+            memcpy(p, bin.data() + pos, n);
+            pos += n;
+            return n;
+        },
+        16);
+    vector<string_view> recs = split_binary_records(bin);
+    string_view obj;
+    ShareSet a, b;
+    for (size_t i = 0; i < recs.size(); ++i) {
+        check(stream.next(obj) && obj == recs[i], "record " + to_string(i) + " streamed whole");
+        check(decode_record(obj, a) && decode_record(recs[i], b) && a.ys == b.ys, "record " + to_string(i) + " decodes");
+    }
+    check(!stream.next(obj), "stream ends after the last record");
+
+    // A header claiming more than kMaxRecordBytes, followed by an endless body.
+    string head(kBinaryMagic, sizeof(kBinaryMagic));
+    head.append(recs[0].substr(0, kRecordHeaderBytes));
+    uint64_t claimed = kMaxRecordBytes + 8;
+    memcpy(&head[sizeof(kBinaryMagic) + 16], &claimed, 8);
+    size_t served = 0;
+    ObjectStream endless(
+        [&](char *p, size_t n) {
+            for (size_t i = 0; i < n; ++i, ++served) p[i] = served < head.size() ? head[served] : 0;
+            return n;
+        },
+        4096);
+    check(endless.next(obj) && !decode_record(obj, a), "an oversized record comes back failing");
+    check(!endless.next(obj), "and ends the stream");
+    check(endless.bytes_read() <= 4096, "without buffering the claimed length: read " + to_string(endless.bytes_read()));
+}
+
+static RegisterTest binary_roundtrip("binary_roundtrip", test_binary_roundtrip);
+static RegisterTest binary_rejects_bad("binary_rejects_bad", test_binary_rejects_bad);
+static RegisterTest stream_records("stream_records", test_stream_records);
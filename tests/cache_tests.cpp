@@ -0,0 +1,150 @@
+// cache_tests.cpp
+// The caches kept across objects and runs, and their files:
+//   weight_cache_file PATH  LagrangeWeightCache saves and reloads through PATH, and rejects
+//                           a file with a corrupted line or a stale entry
+//   result_cache_file PATH  ResultCache drops corrupted lines of PATH and loads the rest
+//   result_cache_budget     a search cut short by its budget leaves no entry behind
+
+#include "shamir_tests.hpp"
+
+static void write_file(const string &path, const vector<string> &lines) {
+    ofstream out(path, ios::trunc);
+    for (const string &l : lines) out << l << '\n';
+}
+
+static vector<string> read_lines(const string &path) {
+    istringstream in(read_file(path));
+    vector<string> lines;
+    for (string l; getline(in, l);) lines.push_back(l);
+    return lines;
+}
+
+// "body sum" with the sum recomputed, as save writes it.
+static string with_sum(const string &body) {
+    ostringstream line;
+    line << body << ' ' << hex << line_hash(body);
+    return line.str();
+}
+
+static string body_of(const string &line) { return line.substr(0, line.rfind(' ')); }
+
+// ---------- weight_cache_file ----------
+static void test_weight_cache_file(const vector<string> &args) {
+    if (args.empty()) throw runtime_error("usage: weight_cache_file PATH");
+    const string &path = args[0], copy = path + ".copy";
+    LagrangeWeightCache &cache = LagrangeWeightCache::global();
+    auto clear = [&] {
+        cache.set_capacity(0);
+        cache.set_capacity(16384);
+    };
+    for (const vector<int> &xs : vector<vector<int>>{{1, 2, 3}, {2, 5, 7, 9}, {1, 4, 6, 10, 11}}) cache.get(xs);
+    check(cache.save(path), "cache saved");
+    vector<string> lines = read_lines(path);
+    check(lines.size() == 3, "one line per x-set, got " + to_string(lines.size()));
+
+    clear();
+    check(cache.load(path) && cache.save(copy) && read_file(copy) == read_file(path),
+          "reloaded cache saves the same file, most recently used first");
+
+    auto rejected = [&](const vector<string> &file, const string &what) {
+        clear();
+        write_file(path, file);
+        bool loaded = cache.load(path);
+        check(!loaded, what + " rejects the file");
+        check(cache.save(copy) && read_file(copy).empty(), what + " loads nothing");
+    };
+    vector<string> bad = lines;
+    bad[1][2] = bad[1][2] == '2' ? '3' : '2';
+    rejected(bad, "a line failing its checksum");
+
+    bad = lines;
+    bad[2] = body_of(bad[2]);
+    rejected(bad, "a line without its checksum");
+
+    // A stale entry: the checksum is right, a weight is not.
+    bad = lines;
+    string body = body_of(bad[0]);
+    size_t cut = body.rfind(' ');
+    bad[0] = with_sum(body.substr(0, cut + 1) + (cpp_int(body.substr(cut + 1)) + 1).str());
+    rejected(bad, "an entry whose weights miss its x-set");
+
+    // Weights that fit the x-set, listed out of order.
+    bad = lines;
+    string &first = bad.back(); // {1, 2, 3}, the least recently used
+    first = with_sum("3 2 1 3" + body_of(first).substr(string("3 1 2 3").size()));
+    rejected(bad, "an unsorted x-set");
+
+    clear();
+    check(cache.load(path + ".missing"), "a missing file is not an error");
+}
+
+// ---------- result_cache_file ----------
+static void test_result_cache_file(const vector<string> &args) {
+    if (args.empty()) throw runtime_error("usage: result_cache_file PATH");
+    const string &path = args[0];
+    ResultCache &cache = ResultCache::global();
+    auto clear = [&] {
+        cache.set_capacity(0);
+        cache.set_capacity(16);
+    };
+    clear();
+    const vector<CachedResult> results = {{true, cpp_int("123456789012345678901234567890"), {2, 7}},
+                                          {false, 0, {}},
+                                          {true, 42, {}}};
+    const vector<string> keys = {string("k\0one", 5), "two", "three"};
+    for (size_t i = 0; i < keys.size(); ++i) cache.put(keys[i], results[i]);
+    check(cache.save(path), "cache saved");
+    vector<string> lines = read_lines(path);
+    check(lines.size() == 3, "one line per entry, got " + to_string(lines.size()));
+
+    auto holds = [&](size_t i) {
+        CachedResult r;
+        return cache.get(keys[i], r) && r.ok == results[i].ok && r.constant == results[i].constant &&
+               r.bad == results[i].bad;
+    };
+    clear();
+    check(cache.load(path), "intact file loads");
+    check(holds(0) && holds(1) && holds(2), "every entry reloaded");
+
+    // lines are most recently used first: "two" is lines[1]
+    vector<string> bad = lines;
+    bad[1][bad[1].rfind(' ') - 1] ^= 1;
+    bad.insert(bad.begin(), "not an entry");
+    bad.push_back(with_sum("zz 1 5"));
+    write_file(path, bad);
+    clear();
+    check(!cache.load(path), "a corrupted file reports the drop");
+    CachedResult r;
+    check(holds(0) && holds(2), "intact entries still loaded");
+    check(!cache.get(keys[1], r), "the corrupted entry is dropped");
+}
+
+// ---------- result_cache_budget ----------
+// Shares 1 and 2 are corrupted, so the first subset in lex order fails and a
+// budget of one subset runs out before any is found.
+static void test_result_cache_budget(const vector<string> &) {
+    ResultCache &cache = ResultCache::global();
+    cache.set_capacity(16);
+    mt19937_64 rng(27);
+    vector<cpp_int> coef;
+    ShareSet set = random_share_set(rng, 10, 5, 64, {1, 2}, &coef);
+    SolveOptions opt;
+    string key;
+    result_cache_key(set, opt, key);
+    CachedResult hit;
+
+    opt.max_combos = 1;
+    ShamirSolver limited(opt);
+    check(limited.solve(set).status == SolveResult::Status::Timeout, "one subset is not enough");
+    check(!cache.get(key, hit), "the cut-short search is not cached");
+
+    ShamirSolver full;
+    const SolveResult &s = full.solve(set);
+    check(s.ok() && s.constant == coef[0], "the unlimited search still runs and finds the constant");
+    check(cache.get(key, hit) && hit.ok && hit.constant == coef[0], "and its result is cached");
+    check(limited.solve(set).ok(), "a limited search now answers from the cache");
+}
+
+static RegisterTest weight_cache_file("weight_cache_file", test_weight_cache_file);
+static RegisterTest result_cache_file("result_cache_file", test_result_cache_file);
+static RegisterTest result_cache_budget("result_cache_budget", test_result_cache_budget);
@@ -0,0 +1,40 @@
+# Runs the solver on one generated corpus with several option sets and fails
+# unless every run prints exactly what the reference run prints. Invoked by
+# CTest with SOLVER, WORK_DIR, SPEC (a --gen spec), REFERENCE (options of the
+# reference run, may be empty) and VARIANTS (option sets separated by "|",
+# options within one set by ",").
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+execute_process(COMMAND ${SOLVER} --gen ${SPEC} OUTPUT_FILE ${WORK_DIR}/corpus.json RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "corpus generation failed (${rc}): ${SPEC}")
+endif()
+
+function(run out)
+  execute_process(COMMAND ${SOLVER} ${ARGN} ${WORK_DIR}/corpus.json
+                  OUTPUT_VARIABLE text ERROR_VARIABLE err RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "run failed (${rc}): ${ARGN}\n${err}")
+  endif()
+  set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "," ";" reference_args "${REFERENCE}")
+run(expected ${reference_args})
+string(REGEX MATCHALL "\n" lines "${expected}")
+list(LENGTH lines count)
+if(count EQUAL 0)
+  message(FATAL_ERROR "reference run printed nothing")
+endif()
+
+string(REPLACE "|" ";" variants "${VARIANTS}")
+foreach(variant IN LISTS variants)
+  string(REPLACE "," ";" args "${variant}")
+  run(actual ${args})
+  if(NOT actual STREQUAL expected)
+    file(WRITE ${WORK_DIR}/expected.txt "${expected}")
+    file(WRITE ${WORK_DIR}/actual.txt "${actual}")
+    message(FATAL_ERROR "output of '${variant}' differs from '${REFERENCE}' (see ${WORK_DIR})")
+  endif()
+endforeach()
+message(STATUS "${count} objects, all option sets agree")
@@ -0,0 +1,42 @@
+// decode_tests.cpp
+// Consensus decoding of corrupted shares (--decode):
+//   decode_bad_shares       --decode recovers the constant and names the corrupted shares
+
+#include "shamir_tests.hpp"
+
+// ---------- decode_bad_shares ----------
+// f(x) = c0 + 3x - 5x^2 + 11x^3 + 2x^4 at x = 1..12 with three shares corrupted,
+// the most (n - k) / 2 allows.
+static void test_decode_bad_shares(const vector<string> &) {
+    const int n = 12, k = 5;
+    const vector<int> corrupt = {3, 8, 11};
+    cpp_int c0("123456789012345678901234567890");
+    for (bool prime_field : {false, true}) {
+        string tag = prime_field ? "GF(p): " : "Z: ";
+        ShareSet set;
+        set.k = k;
+        if (prime_field) set.prime = cpp_int("340282366920938463463374607431768211297");
+        for (int x = 1; x <= n; ++x) {
+            cpp_int y = c0 + 3 * x - 5 * x * x + 11 * x * x * x + 2 * x * x * x * x;
+            if (find(corrupt.begin(), corrupt.end(), x) != corrupt.end()) y += 1000 + x;
+            if (prime_field) y %= set.prime;
+            set.xs.push_back(x);
+            set.ys.push_back(y);
+        }
+        SolveOptions opt;
+        opt.decode = true;
+        ShamirSolver solver(opt);
+        const SolveResult &r = solver.solve(set);
+        check(r.ok(), tag + "decoding succeeds");
+        check(r.constant == (prime_field ? c0 % set.prime : c0), tag + "constant recovered");
+        check(r.bad == corrupt, tag + "bad shares named");
+
+        if (prime_field) continue; // every k-subset interpolates mod p
+        opt.decode = false; // over Z the subset search finds the same constant
+        ShamirSolver search(opt);
+        const SolveResult &s = search.solve(set);
+        check(s.ok() && s.constant == c0, tag + "subset search agrees");
+    }
+}
+
+static RegisterTest decode_bad_shares("decode_bad_shares", test_decode_bad_shares);
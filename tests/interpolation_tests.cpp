@@ -0,0 +1,77 @@
+// interpolation_tests.cpp
+// Interpolation over prime fields past kTreeInterpolationMin, where the
+// subproduct tree replaces the O(k^2) loop:
+//   tree_interpolation      interpolate_coeffs_modp recovers known coefficients at k >= 512,
+//                           and interpolate_coeffs_tree matches the O(k^2) loop below it
+//   decode_many_shares      --decode of n >= 512 shares, in GF(p) and over Z
+
+#include "shamir_tests.hpp"
+
+static const cpp_int kPrime("340282366920938463463374607431768211297");
+
+// ---------- tree_interpolation ----------
+// k = 600 and 1100 leave partial blocks of kTreeLeafBlock points and an
+// unbalanced top of the tree; the x are scattered rather than 1..k.
+static void test_tree_interpolation(const vector<string> &) {
+    using F = FieldFor<256>::type;
+    using E = F::elem;
+    F f(kPrime);
+    mt19937_64 rng(29);
+    auto points = [&](int k, vector<E> &coef, vector<E> &xs, vector<E> &ys) {
+        coef.resize(k);
+        for (E &c : coef) c = f.from_big(random_bits(rng, 127));
+        xs.clear();
+        ys.clear();
+        for (int i = 0; i < k; ++i) {
+            xs.push_back(f.from_int(7 * i + 3));
+            ys.push_back(poly_eval(f, coef, xs.back()));
+        }
+    };
+    vector<E> coef, xs, ys, out;
+    for (int k : {kTreeInterpolationMin, 600, 1100}) {
+        points(k, coef, xs, ys);
+        string tag = "k = " + to_string(k) + ": ";
+        check(interpolate_coeffs_modp(f, xs, ys, out), tag + "interpolation succeeds");
+        check(out == coef, tag + "coefficients recovered");
+    }
+    for (int k : {1, 5, 130, 300, kTreeInterpolationMin - 1}) {
+        points(k, coef, xs, ys);
+        vector<E> tree;
+        string tag = "k = " + to_string(k) + ": ";
+        check(interpolate_coeffs_modp(f, xs, ys, out) && interpolate_coeffs_tree(f, xs, ys, tree),
+              tag + "both interpolations succeed");
+        check(tree == out && out == coef, tag + "tree matches the O(k^2) loop");
+    }
+    xs[1] = xs[0];
+    check(!interpolate_coeffs_tree(f, xs, ys, out), "a repeated x fails the tree interpolation");
+}
+
+// ---------- decode_many_shares ----------
+// Gao's decoder interpolates all n shares, so n >= 512 runs it on the tree.
+static void test_decode_many_shares(const vector<string> &) {
+    mt19937_64 rng(512);
+    for (bool prime_field : {false, true}) {
+        string tag = prime_field ? "GF(p): " : "Z: ";
+        const int n = 600, k = prime_field ? 200 : 8;
+        vector<int> corrupt;
+        for (int x = 5; (int)corrupt.size() < (n - k) / 2; x += 3) corrupt.push_back(x % n + 1);
+        sort(corrupt.begin(), corrupt.end());
+        corrupt.erase(unique(corrupt.begin(), corrupt.end()), corrupt.end());
+        vector<cpp_int> coef;
+        ShareSet set = random_share_set(rng, n, k, 100, corrupt, &coef);
+        if (prime_field) {
+            set.prime = kPrime;
+            for (cpp_int &y : set.ys) y %= kPrime;
+        }
+        SolveOptions opt;
+        opt.decode = true;
+        ShamirSolver solver(opt);
+        const SolveResult &r = solver.solve(set);
+        check(r.ok(), tag + "decoding succeeds");
+        check(r.constant == (prime_field ? coef[0] % kPrime : coef[0]), tag + "constant recovered");
+        check(r.bad == corrupt, tag + to_string(corrupt.size()) + " bad shares named, got " + to_string(r.bad.size()));
+    }
+}
+
+static RegisterTest tree_interpolation("tree_interpolation", test_tree_interpolation);
+static RegisterTest decode_many_shares("decode_many_shares", test_decode_many_shares);
@@ -0,0 +1,130 @@
+// search_tests.cpp
+// The subset search orders and their limits:
+//   revolving_matches_lex   --search revolving finds the constant lex order finds, on shuffled
+//                           shares, with x = 0 and with repeated x
+//   max_combos_timeout      --max-combos stops every search at exactly the limit with TIMEOUT
+
+#include "shamir_tests.hpp"
+
+// The shares of set in a random order, as they may come in from JSON.
+static ShareSet shuffled(mt19937_64 &rng, ShareSet set) {
+    vector<size_t> order(set.xs.size());
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), rng);
+    ShareSet out = set;
+    for (size_t i = 0; i < order.size(); ++i) {
+        out.xs[i] = set.xs[order[i]];
+        out.ys[i] = set.ys[order[i]];
+    }
+    return out;
+}
+
+// ---------- revolving_matches_lex ----------
+// With --consensus requiring every good share only the true polynomial is
+// accepted, so both orders must return its constant whichever subset they meet
+// first. k = 12 is past AdicBatchScreen::kMinK, where lex order screens in batches.
+static void test_revolving_matches_lex(const vector<string> &) {
+    mt19937_64 rng(28);
+    SolveOptions lex, revolving;
+    revolving.search = Search::Revolving;
+    for (auto [n, k, bad] : vector<array<int, 3>>{{6, 3, 1}, {9, 4, 2}, {11, 6, 3}, {10, 7, 1}, {15, 12, 2}})
+        for (int rep = 0; rep < 3; ++rep) {
+            vector<int> corrupt;
+            while ((int)corrupt.size() < bad) {
+                int x = 1 + rng() % n;
+                if (find(corrupt.begin(), corrupt.end(), x) == corrupt.end()) corrupt.push_back(x);
+            }
+            vector<cpp_int> coef;
+            ShareSet set = random_share_set(rng, n, k, 80, corrupt, &coef);
+            if (rep == 2) {
+                set.xs.push_back(0); // a share at x = 0 turns off the weight rescaling
+                set.ys.push_back(coef[0]);
+            }
+            set = shuffled(rng, set);
+            lex.consensus = revolving.consensus = (int)set.xs.size() - bad;
+            ShamirSolver a(lex), b(revolving);
+            const SolveResult &ra = a.solve(set), &rb = b.solve(set);
+            string tag = "n=" + to_string(n) + " k=" + to_string(k) + " rep " + to_string(rep) + ": ";
+            check(ra.ok() && ra.constant == coef[0], tag + "lex finds the constant");
+            check(rb.ok() && rb.constant == coef[0], tag + "revolving finds the constant");
+        }
+
+    // f(x) = 5 + 2x + x^2 with x = 2 given twice, out of order, and one copy
+    // wrong: subsets holding both copies are skipped wherever they sit.
+    ShareSet dup;
+    dup.k = 3;
+    dup.xs = {4, 2, 1, 2, 3};
+    for (int x : dup.xs) dup.ys.push_back(5 + 2 * x + x * x);
+    dup.ys[3] += 1;
+    for (bool tier : {true, false})
+        for (int consensus : {0, 4}) {
+            lex.consensus = revolving.consensus = consensus;
+            lex.fixed_tier = revolving.fixed_tier = tier;
+            ShamirSolver a(lex), b(revolving);
+            string tag = string(tier ? "tier" : "engine") + ", consensus " + to_string(consensus) + ": ";
+            check(solve_text(a, dup) == "5", tag + "repeated x: lex finds 5, got '" + solve_text(a, dup) + "'");
+            check(solve_text(b, dup) == "5", tag + "repeated x: revolving finds 5, got '" + solve_text(b, dup) + "'");
+        }
+
+    // Two distinct x in five shares: every subset repeats one and is turned
+    // away before any interpolation, in either order.
+    ShareSet two = dup;
+    two.xs = {3, 1, 3, 1, 3};
+    g_stats_enabled = true;
+    for (const SolveOptions &opt : {lex, revolving}) {
+        StatCounters &stats = StatCounters::local();
+        stats = StatCounters();
+        ShamirSolver solver(opt);
+        string name = opt.search == Search::Lex ? "lex" : "revolving";
+        check(!solver.solve(two).ok(), name + ": no subset of distinct x");
+        check(stats.interp_calls == 0, name + ": subsets repeating an x never interpolate, got " +
+                                           to_string(stats.interp_calls));
+    }
+    g_stats_enabled = false;
+}
+
+// ---------- max_combos_timeout ----------
+// --consensus n with the last share corrupted accepts no subset, so each search
+// runs until its budget is gone; without it the first k shares form a valid
+// subset, found well inside the budget. 37 cuts a kLanes batch of the
+// k = 12 search in the middle.
+static void test_max_combos_timeout(const vector<string> &) {
+    mt19937_64 rng(20);
+    const uint64_t limit = 37;
+    struct Case {
+        string name;
+        int n, k;
+        Search search;
+        int threads;
+    };
+    for (const Case &c : vector<Case>{{"lex", 10, 5, Search::Lex, 1},
+                                      {"lex batches", 15, 12, Search::Lex, 1},
+                                      {"revolving", 10, 5, Search::Revolving, 1},
+                                      {"threads", 12, 6, Search::Lex, 3}}) {
+        ShareSet set = random_share_set(rng, c.n, c.k, 64, {c.n});
+        SolveOptions opt;
+        opt.search = c.search;
+        opt.threads = c.threads;
+        opt.consensus = c.n;
+        opt.max_combos = limit;
+        ShamirSolver solver(opt);
+        const SolveResult &r = solver.solve(set);
+        uint64_t total = binom_saturated(c.n, c.k);
+        check(r.status == SolveResult::Status::Timeout, c.name + ": TIMEOUT");
+        check(r.tried == limit && r.total == total,
+              c.name + ": tried " + to_string(r.tried) + "/" + to_string(r.total) + ", want " + to_string(limit) +
+                  "/" + to_string(total));
+        check(solve_text(solver, set).rfind("TIMEOUT tried=37/" + to_string(total) + " elapsed_ms=", 0) == 0,
+              c.name + ": status line");
+
+        solver.options().max_combos = total;
+        check(solver.solve(set).status == SolveResult::Status::Failed, c.name + ": a budget of every subset is enough");
+
+        solver.options().consensus = 0;
+        solver.options().max_combos = limit;
+        check(solver.solve(set).ok(), c.name + ": a valid subset inside the budget is still found");
+    }
+}
+
+static RegisterTest revolving_matches_lex("revolving_matches_lex", test_revolving_matches_lex);
+static RegisterTest max_combos_timeout("max_combos_timeout", test_max_combos_timeout);
@@ -0,0 +1,28 @@
+// shamir_tests.cpp
+// Library-level checks run by CTest: ./shamir_tests CASE [ARGS]. The cases
+// live in one source per feature and register themselves (shamir_tests.hpp):
+//   decode_tests.cpp          consensus decoding of corrupted shares
+//   interpolation_tests.cpp   subproduct-tree interpolation for large k
+//   binary_format_tests.cpp   the binary share format and ObjectStream
+//   tier_tests.cpp            the fixed-width integer tier
+//   cache_tests.cpp           the weight and result caches and their files
+//   search_tests.cpp          the subset search orders and their limits
+// Exits nonzero with a line per failed check.
+
+#include "shamir_tests.hpp"
+
+int main(int argc, char **argv) {
+    string name = argc > 1 ? argv[1] : "";
+    auto it = test_cases().find(name);
+    if (it == test_cases().end()) {
+        cerr << "Unknown test: " << name << "\n";
+        return 2;
+    }
+    try {
+        it->second(vector<string>(argv + min(argc, 2), argv + argc));
+    } catch (const exception &e) {
+        cerr << "FAIL: " << name << " threw: " << e.what() << "\n";
+        return 1;
+    }
+    return g_failures ? 1 : 0;
+}
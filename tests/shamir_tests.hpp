@@ -0,0 +1,67 @@
+// shamir_tests.hpp
+// Shared by the library-level test sources. Each source registers its cases
+// with a static RegisterTest; shamir_tests.cpp runs one per CTest entry.
+
+#pragma once
+#include "shamir_parse.hpp"
+using namespace shamir;
+
+inline int g_failures = 0;
+
+inline void check(bool ok, const string &what) {
+    if (ok) return;
+    ++g_failures;
+    cerr << "FAIL: " << what << "\n";
+}
+
+inline string read_file(const string &path) {
+    ifstream in(path, ios::binary);
+    if (!in) throw runtime_error("cannot read " + path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+inline string solve_text(ShamirSolver &solver, const ShareSet &set) {
+    return format_status(solver.solve(set), solver.options());
+}
+
+inline cpp_int random_bits(mt19937_64 &rng, int bits) {
+    cpp_int v = 0;
+    for (int done = 0; done < bits; done += 64) {
+        uint64_t w = rng();
+        if (bits - done < 64) w &= (1ull << (bits - done)) - 1;
+        v |= cpp_int(w) << done;
+    }
+    return v;
+}
+
+// Shares x = 1..n of a random degree k - 1 polynomial with nonnegative
+// coefficients of up to `bits` bits; the shares at `corrupt` (x values) get a
+// random positive error. coef receives the polynomial.
+inline ShareSet random_share_set(mt19937_64 &rng, int n, int k, int bits, const vector<int> &corrupt,
+                                 vector<cpp_int> *coef = nullptr) {
+    vector<cpp_int> c(k);
+    for (cpp_int &v : c) v = random_bits(rng, bits);
+    ShareSet set;
+    set.k = k;
+    for (int x = 1; x <= n; ++x) {
+        cpp_int y = 0;
+        for (int m = k - 1; m >= 0; --m) y = y * x + c[m];
+        if (find(corrupt.begin(), corrupt.end(), x) != corrupt.end()) y += 1 + random_bits(rng, bits);
+        set.xs.push_back(x);
+        set.ys.push_back(y);
+    }
+    if (coef) *coef = move(c);
+    return set;
+}
+
+// args: whatever CTest passes after the case name.
+using TestCase = void (*)(const vector<string> &args);
+
+inline map<string, TestCase> &test_cases() {
+    static map<string, TestCase> cases;
+    return cases;
+}
+
+struct RegisterTest {
+    RegisterTest(const char *name, TestCase fn) { test_cases()[name] = fn; }
+};
@@ -0,0 +1,77 @@
+// tier_tests.cpp
+// The fixed-width integer tier (SmallIntTier), which solves small objects
+// before the exact engines:
+//   tier_matches_engine   with and without the tier every object prints the same,
+//                         across the 128-bit, 256-bit and cpp_int ranges
+//   tier_subsets          which objects get a tier, and the verdict of single subsets
+//   tier_stats            tier solves are counted as interpolations in --stats
+
+#include "shamir_tests.hpp"
+
+// ---------- tier_matches_engine ----------
+// Values around the 100-bit and 220-bit cut-offs, so products overflow the
+// 128-bit tier into the 256-bit one and, past 220 bits, skip the tier; k = 9
+// is above kUnrolledMaxK and runs the generic loop.
+static void test_tier_matches_engine(const vector<string> &) {
+    mt19937_64 rng(21);
+    SolveOptions with_tier, without;
+    without.fixed_tier = false;
+    ShamirSolver tier(with_tier), engine(without);
+    for (int bits : {8, 60, 96, 100, 101, 160, 210, 220, 230})
+        for (int k : {2, 5, 8, 9})
+            for (int rep = 0; rep < 3; ++rep) {
+                int n = k + 3;
+                ShareSet set = random_share_set(rng, n, k, bits, {1 + rep, n - rep});
+                string a = solve_text(tier, set), b = solve_text(engine, set);
+                check(a == b, "bits=" + to_string(bits) + " k=" + to_string(k) + ": tier " + a + ", engine " + b);
+            }
+}
+
+// ---------- tier_subsets ----------
+static void test_tier_subsets(const vector<string> &) {
+    mt19937_64 rng(7);
+    vector<cpp_int> coef;
+    ShareSet set = random_share_set(rng, 6, 4, 90, {2}, &coef);
+    SmallIntTier tier(set.xs, set.ys);
+    check(tier.active(), "90-bit values get a tier");
+    vector<Frac> coeffs;
+    vector<int> good = {0, 2, 3, 4}; // x = 1, 3, 4, 5
+    check(tier.solve(good, coeffs) == 1, "a subset of good shares is integral");
+    bool same = coeffs.size() == coef.size();
+    for (size_t i = 0; same && i < coef.size(); ++i) same = coeffs[i].num == coef[i] && coeffs[i].den == 1;
+    check(same, "the tier returns the polynomial");
+
+    // f(x) = x / 2 through (1, 0) and (3, 1): not integral
+    ShareSet half;
+    half.k = 2;
+    half.xs = {1, 3};
+    half.ys = {0, 1};
+    SmallIntTier small(half.xs, half.ys);
+    check(small.solve({0, 1}, coeffs) == 0, "a non-integral interpolant is rejected");
+
+    ShareSet negative = half;
+    negative.ys[0] = -1;
+    check(!SmallIntTier(negative.xs, negative.ys).active(), "negative values skip the tier");
+    ShareSet wide = random_share_set(rng, 4, 2, 221, {});
+    wide.ys[0] = cpp_int(1) << 220;
+    check(!SmallIntTier(wide.xs, wide.ys).active(), "values over 220 bits skip the tier");
+}
+
+// ---------- tier_stats ----------
+static void test_tier_stats(const vector<string> &) {
+    mt19937_64 rng(3);
+    ShareSet set = random_share_set(rng, 8, 4, 64, {});
+    g_stats_enabled = true;
+    StatCounters &stats = StatCounters::local();
+    stats = StatCounters();
+    ShamirSolver solver;
+    check(solver.solve(set).ok(), "solves");
+    check(stats.interp_calls == 1, "one tier solve counted, got " + to_string(stats.interp_calls));
+    check(stats.combos_tried == 1, "one subset tried, got " + to_string(stats.combos_tried));
+    check(stats.peak_bits > 0, "peak_bits recorded");
+    g_stats_enabled = false;
+}
+
+static RegisterTest tier_matches_engine("tier_matches_engine", test_tier_matches_engine);
+static RegisterTest tier_subsets("tier_subsets", test_tier_subsets);
+static RegisterTest tier_stats("tier_stats", test_tier_stats);